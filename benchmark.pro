@@ -0,0 +1,35 @@
+TEMPLATE = app
+TARGET = benchmark
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+INCLUDEPATH += src
+
+SOURCES += \
+    src/benchmark/main.cpp \
+    src/benchmark/queued.cpp \
+    src/benchmark/memory.cpp \
+    src/benchmark/entity.cpp \
+    src/benchmark/handles.cpp \
+    src/benchmark/prefetch.cpp \
+    src/benchmark/resolved.cpp \
+    src/benchmark/compact.cpp \
+    src/benchmark/compound.cpp \
+    src/benchmark/hybrid.cpp \
+    src/benchmark/erased.cpp \
+    src/benchmark/rcu.cpp \
+    src/benchmark/hazard.cpp \
+    src/benchmark/seqlock.cpp \
+    src/benchmark/striped.cpp \
+    src/benchmark/executor.cpp \
+    src/benchmark/numa.cpp \
+    src/benchmark/confined.cpp
+
+HEADERS += \
+    src/benchmark/benchmark.h \
+    src/benchmark/perf.h
+
+DISTFILES += \
+    src/benchmark/compile-time.sh \
+    src/benchmark/code-size.sh
@@ -7,4 +7,26 @@ SOURCES += \
     src/main.cpp
 
 HEADERS += \
-    src/observer.h
+    src/observer.h \
+    src/dispatcher.h \
+    src/queue.h \
+    src/adaptive.h \
+    src/watchdog.h \
+    src/clock.h \
+    src/latency.h \
+    src/registry.h \
+    src/pool.h \
+    src/prefetch.h \
+    src/resolved.h \
+    src/hybrid.h \
+    src/erased.h \
+    src/epoch.h \
+    src/rcu.h \
+    src/reclaim.h \
+    src/hazard.h \
+    src/seqlock.h \
+    src/striped.h \
+    src/executor.h \
+    src/completion.h \
+    src/numa.h \
+    src/confined.h
@@ -0,0 +1,353 @@
+#ifndef OBSERVER_ADAPTIVE_H
+#define OBSERVER_ADAPTIVE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "dispatcher.h"
+
+namespace Observer
+{
+
+//! Rules, by which an AdaptiveContainer decides that a listener is too slow.
+struct PromotionPolicy
+{
+  //! Every n-th notification is timed, all others are not measured at all.
+  std::uint32_t sampleInterval = 64;
+  //! A handler, which takes longer than this, is considered slow.
+  std::chrono::nanoseconds slowThreshold = std::chrono::microseconds(200);
+  //! Number of consecutive slow samples, after which the listener is promoted.
+  std::uint32_t strikes = 3;
+  //! Lane of the dispatcher, to which notifications of promoted listeners are posted.
+  Priority lane = Priority::Normal;
+};
+
+//! Statistics of an AdaptiveContainer.
+struct PromotionStats
+{
+  //! A listener, which has been moved to asynchronous delivery.
+  struct Promotion
+  {
+    //! The promoted listener.
+    const void* listener = nullptr;
+    //! Duration of the last sampled handler call before the promotion.
+    std::chrono::nanoseconds lastSample{0};
+  };
+
+  //! Number of notifications, which were timed.
+  std::size_t sampledNotifications = 0;
+  //! Number of timed handler calls.
+  std::size_t sampledCalls = 0;
+  //! Number of timed handler calls, which exceeded the threshold.
+  std::size_t slowCalls = 0;
+  //! All promotions in the order they happened.
+  std::vector<Promotion> promotions;
+};
+
+//! A container of listeners, which moves persistently slow listeners to a Dispatcher.
+/*!
+  Listeners are held as raw pointers and called synchronously as in RawContainer.
+  Once in PromotionPolicy::sampleInterval notifications, all synchronous handlers
+  are timed. A listener, which is slow in PromotionPolicy::strikes consecutive
+  samples, is promoted: its notifications are posted to the dispatcher from then on
+  with a copy of the arguments. Fast listeners are not affected by the promotion
+  and notifications, which are not sampled, do not read the clock at all.
+
+  The dispatcher is usually drained on a worker thread, so the promoted listeners
+  must tolerate being called from that thread. Notifications posted before the
+  listener was detached are dropped. If the dispatcher thread is calling a
+  promoted listener, detach() and the destructor block until the call returns,
+  unless they are called from that very call. Without a dispatcher, no listener
+  is promoted.
+*/
+template <class T_Listener>
+class AdaptiveContainer
+{
+public:
+  AdaptiveContainer() = default;
+  AdaptiveContainer(const AdaptiveContainer&) = delete;
+  AdaptiveContainer& operator=(const AdaptiveContainer&) = delete;
+
+  virtual ~AdaptiveContainer()
+  {
+    for (auto& promoted : m_async)
+      promoted.gate->close();
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    assert(listener);
+    m_sync.push_back(listener);
+    m_strikes.push_back(0);
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    for (std::size_t i = 0; i < m_sync.size(); ++i)
+      if (m_sync[i] == listener)
+      {
+        m_sync.erase(m_sync.begin() + i);
+        m_strikes.erase(m_strikes.begin() + i);
+        return;
+      }
+    for (auto it = m_async.begin(); it != m_async.end(); ++it)
+      if (it->listener == listener)
+      {
+        it->gate->close();
+        m_async.erase(it);
+        return;
+      }
+  }
+
+  //! Memory occupied by this container.
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage = detail::vectorUsage(m_sync, sizeof(*this));
+    usage += detail::vectorUsage(m_strikes, 0);
+    usage += detail::vectorUsage(m_async, 0);
+    usage += detail::vectorUsage(m_stats.promotions, 0);
+    usage.bytesUsed += m_async.size() * sizeof(Gate);
+    usage.bytesReserved += m_async.size() * sizeof(Gate);
+    usage.liveEntries = m_sync.size() + m_async.size();
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    m_sync.shrink_to_fit();
+    m_strikes.shrink_to_fit();
+    m_async.shrink_to_fit();
+  }
+
+  //! Set the dispatcher, which receives notifications of promoted listeners.
+  void setDispatcher(Dispatcher* dispatcher)
+  {
+    m_dispatcher = dispatcher;
+  }
+
+  //! Set the rules of promotion.
+  void setPolicy(const PromotionPolicy& policy)
+  {
+    assert(policy.sampleInterval > 0 && policy.strikes > 0);
+    m_policy = policy;
+    m_untilSample = policy.sampleInterval;
+  }
+
+  //! Statistics of sampling and promotions.
+  const PromotionStats& promotionStats() const
+  {
+    return m_stats;
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    Synchronous listeners are called directly, notifications of promoted
+    listeners are posted to the dispatcher.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    // Arguments are copied for the promoted listeners first, as the synchronous
+    // calls may move from them.
+    for (auto& promoted : m_async)
+      m_dispatcher->post(m_policy.lane,
+        [listener = promoted.listener, gate = promoted.gate, fn,
+         params = std::make_tuple(std::decay_t<Fn_Args>(args)...)]() mutable
+        {
+          if (!gate->enter())
+            return;
+          std::apply([listener, fn](auto&... values)
+            {
+              if (auto* monitor = detail::CallMonitor::sample())
+                detail::CallMonitor::timedCall(monitor, listener, fn, static_cast<Fn_Args&&>(values)...);
+              else
+                (listener->*fn)(static_cast<Fn_Args&&>(values)...);
+            }, params);
+          gate->leave();
+        });
+
+    if (m_dispatcher && --m_untilSample == 0)
+    {
+      m_untilSample = m_policy.sampleInterval;
+      sampledNotify(detail::CallMonitor::sample(), fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto& l : m_sync)
+        detail::CallMonitor::timedCall(monitor, l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto& l : m_sync)
+      (l->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  //! Lets posted notifications call a promoted listener until it is detached.
+  /*!
+    The state counts calls in progress in the upper bits and has the lowest
+    bit set once the listener is detached, so close() can wait for the calls.
+  */
+  class Gate
+  {
+  public:
+    //! Start a call, returns false if the listener has been detached.
+    bool enter()
+    {
+      if (m_state.fetch_add(2, std::memory_order_seq_cst) & Closed)
+      {
+        m_state.fetch_sub(2, std::memory_order_relaxed);
+        return false;
+      }
+      t_calls.push_back(this);
+      return true;
+    }
+
+    //! Finish the call, the call it has interrupted, if any, becomes the current one again.
+    void leave()
+    {
+      t_calls.pop_back();
+      m_state.fetch_sub(2, std::memory_order_release);
+    }
+
+    //! Stop further calls and wait for calls in progress, except for those made by the calling thread.
+    void close()
+    {
+      const std::uint32_t own = 2 * static_cast<std::uint32_t>(std::count(t_calls.begin(), t_calls.end(), this));
+      std::uint32_t state = m_state.fetch_or(Closed, std::memory_order_seq_cst) | Closed;
+      while ((state & ~Closed) > own)
+      {
+        std::this_thread::yield();
+        state = m_state.load(std::memory_order_acquire);
+      }
+    }
+
+  private:
+    static constexpr std::uint32_t Closed = 1;
+
+    std::atomic<std::uint32_t> m_state{0};
+    // Gates of the calls in progress on the thread, calls nest if a listener drains the dispatcher.
+    static inline thread_local std::vector<const Gate*> t_calls;
+  };
+
+  struct Promoted
+  {
+    T_Listener* listener;
+    std::shared_ptr<Gate> gate;
+  };
+
+  //! Time every synchronous call, the durations are reported to \a monitor too, unless it is null.
+  template <typename... Fn_Args>
+  void sampledNotify(detail::CallMonitor* monitor, void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    ++m_stats.sampledNotifications;
+    bool promote = false;
+    std::vector<std::chrono::nanoseconds> samples(m_sync.size());
+    for (std::size_t i = 0; i < m_sync.size(); ++i)
+    {
+      auto start = Clock::now();
+      (m_sync[i]->*fn)(std::forward<Fn_Args>(args)...);
+      std::chrono::nanoseconds elapsed = Clock::now() - start;
+      if (monitor)
+        monitor->report(m_sync[i], MethodId(fn), elapsed);
+
+      ++m_stats.sampledCalls;
+      if (i < samples.size())
+        samples[i] = elapsed;
+      if (elapsed > m_policy.slowThreshold)
+      {
+        ++m_stats.slowCalls;
+        // Not compared for equality, setPolicy() may have lowered the strikes below the count.
+        if (++m_strikes[i] >= m_policy.strikes)
+          promote = true;
+      }
+      else
+        m_strikes[i] = 0;
+    }
+
+    if (promote)
+      promoteSlowListeners(samples);
+  }
+
+  //! Promote listeners with enough strikes, \a samples are the durations of their last calls.
+  void promoteSlowListeners(const std::vector<std::chrono::nanoseconds>& samples)
+  {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_sync.size(); ++i)
+    {
+      if (m_strikes[i] >= m_policy.strikes)
+      {
+        m_stats.promotions.push_back({ m_sync[i], i < samples.size() ? samples[i] : std::chrono::nanoseconds(0) });
+        m_async.push_back({ m_sync[i], std::make_shared<Gate>() });
+        continue;
+      }
+      m_sync[kept] = m_sync[i];
+      m_strikes[kept] = m_strikes[i];
+      ++kept;
+    }
+    m_sync.resize(kept);
+    m_strikes.resize(kept);
+  }
+
+  std::vector<T_Listener*> m_sync;
+  std::vector<std::uint32_t> m_strikes;
+  std::vector<Promoted> m_async;
+  Dispatcher* m_dispatcher = nullptr;
+  PromotionPolicy m_policy;
+  std::uint32_t m_untilSample = PromotionPolicy().sampleInterval;
+  PromotionStats m_stats;
+};
+
+//! Base class for sources, which move slow listeners to asynchronous delivery.
+/*!
+  All listener containers of the source post notifications of promoted listeners
+  to the dispatcher given in the constructor.
+*/
+template <class... T_Listeners>
+class AdaptiveSource
+  : public Source<AdaptiveContainer, T_Listeners...>
+{
+public:
+  explicit AdaptiveSource(Dispatcher& dispatcher)
+  {
+    (AdaptiveContainer<T_Listeners>::setDispatcher(&dispatcher), ...);
+  }
+
+  //! Set the rules of promotion of listeners of all types.
+  void setPolicy(const PromotionPolicy& policy)
+  {
+    (AdaptiveContainer<T_Listeners>::setPolicy(policy), ...);
+  }
+
+  //! Statistics of listener \a T.
+  template <class T>
+  const PromotionStats& promotionStats() const
+  {
+    return AdaptiveContainer<T>::promotionStats();
+  }
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_ADAPTIVE_H
@@ -0,0 +1,119 @@
+#ifndef OBSERVER_BENCHMARK_H
+#define OBSERVER_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Benchmark
+{
+
+using Clock = std::chrono::steady_clock;
+
+//! Command line options shared by all scenarios.
+struct Options
+{
+  //! Multiplier of the problem size and duration of every scenario.
+  double scale = 1.0;
+};
+
+//! Measures the time elapsed since construction or the last restart().
+class Stopwatch
+{
+public:
+  Stopwatch() : m_start(Clock::now()) {}
+
+  void restart() { m_start = Clock::now(); }
+
+  double seconds() const
+  {
+    return std::chrono::duration<double>(Clock::now() - m_start).count();
+  }
+
+  double nanoseconds() const
+  {
+    return std::chrono::duration<double, std::nano>(Clock::now() - m_start).count();
+  }
+
+private:
+  Clock::time_point m_start;
+};
+
+//! Collects samples and reports their percentiles.
+class Samples
+{
+public:
+  void reserve(std::size_t count) { m_values.reserve(count); }
+  void add(double value) { m_values.push_back(value); m_sorted = false; }
+  std::size_t count() const { return m_values.size(); }
+
+  //! Returns the percentile \a p, which is given in range <0, 100>.
+  double percentile(double p)
+  {
+    if (m_values.empty())
+      return 0.0;
+    sort();
+    auto index = static_cast<std::size_t>(p / 100.0 * (m_values.size() - 1) + 0.5);
+    return m_values[index];
+  }
+
+  double max()
+  {
+    return percentile(100.0);
+  }
+
+private:
+  void sort()
+  {
+    if (!m_sorted)
+      std::sort(m_values.begin(), m_values.end());
+    m_sorted = true;
+  }
+
+  std::vector<double> m_values;
+  bool m_sorted = false;
+};
+
+//! Prevents the compiler from optimizing away a computation of \a value.
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+//! Print the title of a scenario.
+inline void printTitle(const std::string& title)
+{
+  std::printf("\n== %s ==\n", title.c_str());
+}
+
+// Scenarios
+
+void queuedLatency(const Options& options);
+void memoryFootprint(const Options& options);
+void entitySimulation(const Options& options);
+void handleBandwidth(const Options& options);
+void prefetchDistance(const Options& options);
+void resolvedCalls(const Options& options);
+void compaction(const Options& options);
+void compoundEvents(const Options& options);
+void hybridCalibration(const Options& options);
+void erasedNotify(const Options& options);
+void rcuNotify(const Options& options);
+void hazardReclamation(const Options& options);
+void seqlockNotify(const Options& options);
+void stripedChurn(const Options& options);
+void executorFanOut(const Options& options);
+void numaPlacement(const Options& options);
+void confinedNotify(const Options& options);
+
+} // namespace Benchmark
+
+#endif // OBSERVER_BENCHMARK_H
@@ -0,0 +1,75 @@
+#!/bin/sh
+# Code-size benchmark of templated and type-erased notification loops.
+#
+# Generates a translation unit with a source of N listener interfaces of four
+# notification methods each, all of which are emitted. The unit is compiled
+# with RawContainer and with ErasedContainer and the size of the code of both
+# object files is reported.
+#
+# usage: src/benchmark/code-size.sh [N...]
+# The compiler is taken from $CXX, default c++, extra flags from $CXXFLAGS.
+
+set -e
+
+src=$(cd "$(dirname "$0")/.." && pwd)
+cxx=${CXX:-c++}
+flags=${CXXFLAGS:--O2}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+[ $# -gt 0 ] || set -- 10 40 160
+
+generate()
+{
+  n=$1
+  echo '#include <string>'
+  echo '#include "erased.h"'
+  i=0
+  while [ $i -lt $n ]; do
+    echo "struct Interface$i {"
+    echo "  virtual ~Interface$i() {}"
+    echo "  virtual void changed$i(int) = 0;"
+    echo "  virtual void moved$i(double, double) = 0;"
+    echo "  virtual void renamed$i(const std::string&) = 0;"
+    echo "  virtual void reset$i() = 0;"
+    echo "};"
+    i=$((i + 1))
+  done
+
+  list=$(i=0; while [ $i -lt $n ]; do printf 'Interface%d' $i; [ $((i + 1)) -lt $n ] && printf ', '; i=$((i + 1)); done)
+
+  echo "struct Station : Observer::Source<Observer::OBSERVER_CONTAINER, $list> {"
+  i=0
+  while [ $i -lt $n ]; do
+    echo "  void emit$i(const std::string& name) {"
+    echo "    notify(&Interface$i::changed$i, $i);"
+    echo "    notify(&Interface$i::moved$i, 1.0 * $i, 2.0);"
+    echo "    notify(&Interface$i::renamed$i, name);"
+    echo "    notify(&Interface$i::reset$i);"
+    echo "  }"
+    i=$((i + 1))
+  done
+  echo "};"
+
+  echo "void run(Station& station, const std::string& name) {"
+  i=0
+  while [ $i -lt $n ]; do
+    echo "  station.emit$i(name);"
+    i=$((i + 1))
+  done
+  echo "}"
+}
+
+text()
+{
+  size -A "$1" | awk '$1 ~ /^\.text/ { sum += $2 } END { print sum }'
+}
+
+printf '%10s %12s %12s %12s\n' interfaces "raw KiB" "erased KiB" "saved"
+for n in "$@"; do
+  generate "$n" > "$work/station$n.cpp"
+  $cxx -std=c++17 $flags -I"$src" -DOBSERVER_CONTAINER=RawContainer -c "$work/station$n.cpp" -o "$work/raw$n.o"
+  $cxx -std=c++17 $flags -I"$src" -DOBSERVER_CONTAINER=ErasedContainer -c "$work/station$n.cpp" -o "$work/erased$n.o"
+  awk -v n="$n" -v r="$(text "$work/raw$n.o")" -v e="$(text "$work/erased$n.o")" \
+    'BEGIN { printf "%10d %12.1f %12.1f %11.1f%%\n", n, r / 1024, e / 1024, 100 * (r - e) / r }'
+done
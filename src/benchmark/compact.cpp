@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+#include "perf.h"
+#include "pool.h"
+
+// Listeners are allocated in one order and attached in another one, as they
+// are after a history of churn. Notifications are measured before and after
+// compact() sorts the listeners by address.
+
+namespace
+{
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { m_sum += value; }
+
+private:
+  long long m_sum = 0;
+  char m_padding[48];
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+struct Result
+{
+  double nanoseconds;
+  std::string cacheMisses;
+  std::string l1Misses;
+};
+
+template <class T_Ticker>
+Result measure(T_Ticker& ticker, std::size_t listeners, std::size_t rounds)
+{
+  ticker.tick(0);
+  Benchmark::PerfCounters counters;
+  Benchmark::Stopwatch stopwatch;
+  counters.start();
+  for (std::size_t round = 0; round < rounds; ++round)
+    ticker.tick(static_cast<int>(round));
+  counters.stop();
+  double calls = double(listeners) * rounds;
+  return { stopwatch.nanoseconds() / calls,
+    counters.perItem(Benchmark::PerfCounters::CacheMisses, calls),
+    counters.perItem(Benchmark::PerfCounters::L1DataMisses, calls) };
+}
+
+template <class T_Source, class T_Listeners>
+void run(const char* name, const T_Listeners& listeners, std::size_t rounds)
+{
+  Ticker<T_Source> ticker;
+  for (const auto& listener : listeners)
+    ticker.attach(listener);
+
+  auto before = measure(ticker, listeners.size(), rounds);
+  Benchmark::Stopwatch stopwatch;
+  ticker.compact();
+  double compactMilliseconds = stopwatch.seconds() * 1e3;
+  auto after = measure(ticker, listeners.size(), rounds);
+
+  std::printf("%-8s %-8s %10.2f %11s %11s\n", name, "shuffled",
+    before.nanoseconds, before.cacheMisses.c_str(), before.l1Misses.c_str());
+  std::printf("%-8s %-8s %10.2f %11s %11s %11.2f\n", name, "compact",
+    after.nanoseconds, after.cacheMisses.c_str(), after.l1Misses.c_str(), compactMilliseconds);
+}
+
+}
+
+namespace Benchmark
+{
+
+void compaction(const Options& options)
+{
+  auto count = std::max<std::size_t>(static_cast<std::size_t>(1000000 * options.scale), 1);
+  std::size_t rounds = 5;
+
+  printTitle("Compaction: " + std::to_string(count) + " listeners attached in random order");
+  std::printf("%-8s %-8s %10s %11s %11s %11s\n",
+    "source", "order", "ns/call", "LLC/call", "L1D/call", "compact ms");
+
+  std::mt19937 random(13);
+  std::vector<TickObserver> observers(count);
+  std::vector<Observer::Listener<TickListener>*> raw;
+  for (auto& observer : observers)
+    raw.push_back(&observer);
+  std::shuffle(raw.begin(), raw.end(), random);
+
+  run<Observer::RawSource<TickListener>>("raw", raw, rounds);
+  // Slots of the pool stay in the order of attachment, so sorted handles still
+  // visit the pool at random, which does not pay off unless the pool is small.
+  run<Observer::PoolSource<TickListener>>("pool", raw, rounds);
+
+  std::vector<std::shared_ptr<Observer::Listener<TickListener>>> smart;
+  for (std::size_t i = 0; i < count; ++i)
+    smart.push_back(std::make_shared<TickObserver>());
+  std::shuffle(smart.begin(), smart.end(), random);
+
+  run<Observer::SmartSource<TickListener>>("smart", smart, rounds);
+}
+
+} // namespace Benchmark
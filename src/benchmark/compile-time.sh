@@ -0,0 +1,88 @@
+#!/bin/sh
+# Compile-time benchmark of Source with many listener interfaces.
+#
+# Generates a translation unit with a source of N listener interfaces, a
+# listener implementing all of them and N/4 listeners implementing four of
+# them each. All listeners are attached, detached and notified.
+# Reports the time to compile it and the size of the object file.
+#
+# usage: src/benchmark/compile-time.sh [N...]
+# The compiler is taken from $CXX, default c++, extra flags from $CXXFLAGS.
+
+set -e
+
+src=$(cd "$(dirname "$0")/.." && pwd)
+cxx=${CXX:-c++}
+flags=${CXXFLAGS:--O2}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+[ $# -gt 0 ] || set -- 1 10 20 40 80
+
+generate()
+{
+  n=$1
+  echo '#include "observer.h"'
+  i=0
+  while [ $i -lt $n ]; do
+    echo "struct Interface$i { virtual ~Interface$i() {} virtual void on$i(int) = 0; };"
+    i=$((i + 1))
+  done
+
+  list=$(i=0; while [ $i -lt $n ]; do printf 'Interface%d' $i; [ $((i + 1)) -lt $n ] && printf ', '; i=$((i + 1)); done)
+
+  echo "struct Impl : Observer::Listener<$list> {"
+  i=0
+  while [ $i -lt $n ]; do
+    echo "  void on$i(int v) override { sum += v; }"
+    i=$((i + 1))
+  done
+  echo "  long sum = 0;"
+  echo "};"
+
+  i=0
+  while [ $((i + 4)) -le $n ]; do
+    echo "struct Part$i : Observer::Listener<Interface$i, Interface$((i + 1)), Interface$((i + 2)), Interface$((i + 3))> {"
+    j=$i
+    while [ $j -lt $((i + 4)) ]; do
+      echo "  void on$j(int) override {}"
+      j=$((j + 1))
+    done
+    echo "};"
+    i=$((i + 4))
+  done
+
+  echo "struct Raw : Observer::RawSource<$list> {"
+  echo "  void fire() {"
+  i=0
+  while [ $i -lt $n ]; do
+    echo "    notify(&Interface$i::on$i, $i);"
+    i=$((i + 1))
+  done
+  echo "  }"
+  echo "};"
+
+  echo "struct Smart : Observer::SmartSource<$list> {};"
+
+  echo "long run() {"
+  echo "  Impl impl; Raw raw; raw.attach(&impl); raw.fire(); raw.detach(&impl);"
+  echo "  auto shared = std::make_shared<Impl>(); Smart smart; smart.attach(shared); smart.detach(shared);"
+  i=0
+  while [ $((i + 4)) -le $n ]; do
+    echo "  { Part$i part; raw.attach(&part); raw.fire(); raw.detach(&part);"
+    echo "    auto sharedPart = std::make_shared<Part$i>(); smart.attach(sharedPart); smart.detach(sharedPart); }"
+    i=$((i + 4))
+  done
+  echo "  return impl.sum;"
+  echo "}"
+}
+
+printf '%10s %12s %12s\n' interfaces "compile s" "object KiB"
+for n in "$@"; do
+  generate "$n" > "$work/source$n.cpp"
+  start=$(date +%s.%N)
+  $cxx -std=c++17 $flags -I"$src" -c "$work/source$n.cpp" -o "$work/source$n.o"
+  end=$(date +%s.%N)
+  size=$(wc -c < "$work/source$n.o")
+  awk -v n="$n" -v s="$start" -v e="$end" -v b="$size" 'BEGIN { printf "%10d %12.2f %12.1f\n", n, e - s, b / 1024 }'
+done
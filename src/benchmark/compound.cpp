@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+
+// A compound event, a click, is sent as two notifications, either one after
+// another, or by one notifyAll(), which visits every listener just once.
+
+namespace
+{
+
+class MouseListener {
+public:
+  virtual ~MouseListener() {}
+  virtual void onPress(int x, int y) = 0;
+  virtual void onRelease(int x, int y) = 0;
+};
+
+class MouseObserver : public Observer::Listener<MouseListener> {
+public:
+  void onPress(int x, int y) override { m_sum += x + y; }
+  void onRelease(int x, int y) override { m_sum -= x - y; }
+
+private:
+  long long m_sum = 0;
+};
+
+template <class T_Base>
+class Mouse : public T_Base {
+public:
+  void clickSeparately(int x, int y)
+  {
+    this->notify(&MouseListener::onPress, int(x), int(y));
+    this->notify(&MouseListener::onRelease, int(x), int(y));
+  }
+
+  void clickTogether(int x, int y)
+  {
+    this->notifyAll(Observer::call(&MouseListener::onPress, int(x), int(y)),
+      Observer::call(&MouseListener::onRelease, int(x), int(y)));
+  }
+};
+
+template <class T_Mouse, class T_Click>
+double measure(T_Mouse& mouse, std::size_t listeners, std::size_t clicks, T_Click click)
+{
+  Benchmark::Stopwatch stopwatch;
+  for (std::size_t i = 0; i < clicks; ++i)
+    click(mouse, static_cast<int>(i));
+  return stopwatch.nanoseconds() / (double(clicks) * listeners);
+}
+
+template <class T_Source, class T_Listeners>
+void run(const char* name, const T_Listeners& listeners, std::size_t clicks)
+{
+  Mouse<T_Source> mouse;
+  for (const auto& listener : listeners)
+    mouse.attach(listener);
+
+  auto separately = [](auto& m, int i) { m.clickSeparately(i, i + 1); };
+  auto together = [](auto& m, int i) { m.clickTogether(i, i + 1); };
+  measure(mouse, listeners.size(), clicks / 10 + 1, separately);
+  double separateNanoseconds = measure(mouse, listeners.size(), clicks, separately);
+  double togetherNanoseconds = measure(mouse, listeners.size(), clicks, together);
+
+  std::printf("%-8s %10zu %14.2f %14.2f %9.2f\n", name, listeners.size(),
+    separateNanoseconds, togetherNanoseconds, separateNanoseconds / togetherNanoseconds);
+}
+
+}
+
+namespace Benchmark
+{
+
+void compoundEvents(const Options& options)
+{
+  auto clicks = std::max<std::size_t>(static_cast<std::size_t>(20000 * options.scale), 1);
+
+  printTitle("Compound events: press and release sent separately or by notifyAll()");
+  std::printf("%-8s %10s %14s %14s %9s\n", "source", "listeners", "separate ns", "notifyAll ns", "speedup");
+
+  for (std::size_t count : { 16, 256, 4096 })
+  {
+    std::vector<MouseObserver> observers(count);
+    std::vector<Observer::Listener<MouseListener>*> raw;
+    for (auto& observer : observers)
+      raw.push_back(&observer);
+
+    std::vector<std::shared_ptr<Observer::Listener<MouseListener>>> smart;
+    for (std::size_t i = 0; i < count; ++i)
+      smart.push_back(std::make_shared<MouseObserver>());
+
+    auto rounds = std::max<std::size_t>(clicks * 64 / count, 1);
+    run<Observer::RawSource<MouseListener>>("raw", raw, rounds);
+    run<Observer::SmartSource<MouseListener>>("smart", smart, rounds);
+  }
+}
+
+} // namespace Benchmark
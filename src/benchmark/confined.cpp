@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "confined.h"
+#include "observer.h"
+#include "rcu.h"
+
+// The thread owning a source notifies it, while another thread replaces one
+// of its listeners every 100 microseconds or never. The thread-confined
+// source is compared with RawContainer, which cannot be changed by another
+// thread, and with the copy-on-write container.
+
+namespace
+{
+
+const auto ChurnPeriod = std::chrono::microseconds(100);
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { Benchmark::doNotOptimize(m_weight * value); }
+
+private:
+  int m_weight = 3;
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+template <class T_Source>
+void run(const char* name, std::size_t listeners, bool churn, std::size_t count)
+{
+  std::vector<TickObserver> observers(listeners + 1);
+  Ticker<T_Source> ticker;
+  for (std::size_t i = 0; i < listeners; ++i)
+    ticker.attach(&observers[i]);
+
+  std::atomic<bool> running(true);
+  std::size_t churns = 0;
+  std::thread churner;
+  if (churn)
+  {
+    churner = std::thread([&]
+    {
+      Observer::Listener<TickListener>* attached = &observers[0];
+      Observer::Listener<TickListener>* spare = &observers[listeners];
+      while (running.load(std::memory_order_acquire))
+      {
+        ticker.detach(attached);
+        ticker.attach(spare);
+        std::swap(attached, spare);
+        ++churns;
+        std::this_thread::sleep_for(ChurnPeriod);
+      }
+    });
+  }
+
+  Benchmark::Stopwatch stopwatch;
+  for (std::size_t i = 0; i < count; ++i)
+    ticker.tick(static_cast<int>(i));
+  const double nanoseconds = stopwatch.nanoseconds() / count;
+
+  running.store(false, std::memory_order_release);
+  if (churner.joinable())
+    churner.join();
+  std::printf("%-10s %10zu %8s %12.2f %10zu\n", name, listeners, churn ? "yes" : "no", nanoseconds, churns);
+}
+
+}
+
+namespace Benchmark
+{
+
+void confinedNotify(const Options& options)
+{
+  auto count = std::max<std::size_t>(static_cast<std::size_t>(2000000 * options.scale), 1);
+
+  printTitle("Notifications by the owner thread, another thread replaces a listener every 100 us");
+  std::printf("%-10s %10s %8s %12s %10s\n", "container", "listeners", "churn", "ns/notify", "churns");
+
+  for (std::size_t listeners : { 4, 64 })
+  {
+    run<Observer::RawSource<TickListener>>("raw", listeners, false, count);
+    run<Observer::ConfinedSource<TickListener>>("confined", listeners, false, count);
+    run<Observer::ConfinedSource<TickListener>>("confined", listeners, true, count);
+    run<Observer::RcuSource<TickListener>>("rcu", listeners, true, count);
+  }
+}
+
+} // namespace Benchmark
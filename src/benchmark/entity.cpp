@@ -0,0 +1,213 @@
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "adaptive.h"
+#include "benchmark.h"
+#include "dispatcher.h"
+#include "hybrid.h"
+#include "observer.h"
+#include "perf.h"
+#include "pool.h"
+#include "registry.h"
+
+// Simulation of a world of many entities. Each entity is a source with zero
+// to two listeners and notifications are spread randomly over all entities.
+
+namespace
+{
+
+class EntityListener {
+public:
+  virtual ~EntityListener() {}
+  virtual void onChanged(int value) = 0;
+};
+
+class EntityObserver : public Observer::Listener<EntityListener> {
+public:
+  void onChanged(int value) override { m_sum += value; }
+
+private:
+  long long m_sum = 0;
+};
+
+template <class T_Base>
+class Entity : public T_Base {
+public:
+  using T_Base::T_Base;
+
+  void changed(int value) { this->notify(&EntityListener::onChanged, int(value)); }
+};
+
+//! Listeners held by raw pointers, each allocated separately.
+struct RawListeners
+{
+  explicit RawListeners(std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      observers.push_back(std::make_unique<EntityObserver>());
+  }
+
+  EntityObserver* operator[](std::size_t index) const { return observers[index].get(); }
+  std::size_t size() const { return observers.size(); }
+
+  std::vector<std::unique_ptr<EntityObserver>> observers;
+};
+
+//! Listeners held by shared pointers.
+struct SmartListeners
+{
+  explicit SmartListeners(std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      observers.push_back(std::make_shared<EntityObserver>());
+  }
+
+  const std::shared_ptr<EntityObserver>& operator[](std::size_t index) const { return observers[index]; }
+  std::size_t size() const { return observers.size(); }
+
+  std::vector<std::shared_ptr<EntityObserver>> observers;
+};
+
+struct World
+{
+  std::size_t entities;
+  std::size_t notifications;
+  std::size_t churn;
+};
+
+//! Notify every entity once by iterating all of them.
+struct SweepEntities
+{
+  template <class T_Entities>
+  void operator()(T_Entities& entities) const
+  {
+    for (auto& entity : entities)
+      entity.changed(1);
+  }
+};
+
+//! Run the simulation for entities of type \a T_Entity.
+/*!
+  \a create adds a new entity to the given deque and \a flush is called
+  after every batch of notifications, e.g. to drain a dispatcher. \a sweep
+  notifies every entity once.
+*/
+template <class T_Entity, class T_Listeners, class T_Create, class T_Flush, class T_Sweep = SweepEntities>
+void simulate(const char* name, const World& world, const T_Listeners& listeners,
+  T_Create create, T_Flush flush, T_Sweep sweep = T_Sweep())
+{
+  std::mt19937 random(7);
+  std::uniform_int_distribution<std::size_t> pickEntity(0, world.entities - 1);
+  std::uniform_int_distribution<std::size_t> pickListener(0, listeners.size() - 1);
+
+  std::deque<T_Entity> entities;
+  for (std::size_t i = 0; i < world.entities; ++i)
+  {
+    create(entities);
+    // 60 % of entities have no listener, 30 % one and 10 % two.
+    auto roll = random() % 10;
+    std::size_t count = roll < 6 ? 0 : roll < 9 ? 1 : 2;
+    for (std::size_t j = 0; j < count; ++j)
+      entities.back().attach(listeners[pickListener(random)]);
+  }
+
+  Observer::MemoryUsage usage;
+  for (const auto& entity : entities)
+    usage += entity.memoryUsage();
+
+  std::vector<std::uint32_t> targets(world.notifications);
+  for (auto& target : targets)
+    target = static_cast<std::uint32_t>(pickEntity(random));
+
+  Benchmark::PerfCounters counters;
+  Benchmark::Stopwatch stopwatch;
+  counters.start();
+  for (std::size_t i = 0; i < targets.size(); ++i)
+  {
+    entities[targets[i]].changed(static_cast<int>(i));
+    if ((i & 1023) == 1023)
+      flush();
+  }
+  flush();
+  counters.stop();
+  double notifySeconds = stopwatch.seconds();
+
+  stopwatch.restart();
+  for (std::size_t i = 0; i < world.churn; ++i)
+  {
+    auto& entity = entities[pickEntity(random)];
+    const auto& listener = listeners[pickListener(random)];
+    entity.attach(listener);
+    entity.detach(listener);
+  }
+  double churnNanoseconds = stopwatch.nanoseconds() / world.churn;
+
+  stopwatch.restart();
+  sweep(entities);
+  flush();
+  double sweepMilliseconds = stopwatch.seconds() * 1e3;
+
+  std::printf("%-10s %7zu %11.1f %11.2f %10s %10s %10s %12.1f %9.2f\n",
+    name, sizeof(T_Entity), double(usage.bytesReserved) / world.entities,
+    world.notifications / notifySeconds / 1e6,
+    counters.perItem(Benchmark::PerfCounters::CacheMisses, double(world.notifications)).c_str(),
+    counters.perItem(Benchmark::PerfCounters::L1DataMisses, double(world.notifications)).c_str(),
+    counters.ratio(Benchmark::PerfCounters::CacheMisses, Benchmark::PerfCounters::CacheReferences).c_str(),
+    churnNanoseconds, sweepMilliseconds);
+}
+
+}
+
+namespace Benchmark
+{
+
+void entitySimulation(const Options& options)
+{
+  World world;
+  world.entities = static_cast<std::size_t>(2000000 * options.scale);
+  world.notifications = static_cast<std::size_t>(4000000 * options.scale);
+  world.churn = static_cast<std::size_t>(500000 * options.scale);
+  std::size_t listenerCount = world.entities / 4 + 1;
+
+  printTitle("Entity simulation: " + std::to_string(world.entities) + " sources with 0-2 listeners, "
+    + std::to_string(world.notifications) + " random notifications");
+  std::printf("%-10s %7s %11s %11s %10s %10s %10s %12s %9s\n",
+    "container", "sizeof", "storage/src", "Mnotify/s", "LLC/notify", "L1D/notify", "LLC miss", "churn ns/op",
+    "sweep ms");
+
+  auto noFlush = [] {};
+  RawListeners raw(listenerCount);
+  SmartListeners smart(listenerCount);
+
+  simulate<Entity<Observer::RawSource<EntityListener>>>("raw", world, raw,
+    [](auto& entities) { entities.emplace_back(); }, noFlush);
+
+  simulate<Entity<Observer::SmartSource<EntityListener>>>("smart", world, smart,
+    [](auto& entities) { entities.emplace_back(); }, noFlush);
+
+  simulate<Entity<Observer::PoolSource<EntityListener>>>("pool", world, raw,
+    [](auto& entities) { entities.emplace_back(); }, noFlush);
+
+  // Zero to two listeners always fit the inline storage.
+  simulate<Entity<Observer::HybridSource<EntityListener>>>("hybrid", world, raw,
+    [](auto& entities) { entities.emplace_back(); }, noFlush);
+
+  Observer::Dispatcher dispatcher;
+  auto drain = [&dispatcher] { dispatcher.drain(); };
+
+  simulate<Entity<Observer::QueuedSource<EntityListener>>>("queued", world, raw,
+    [&dispatcher](auto& entities) { entities.emplace_back(dispatcher); }, drain);
+
+  simulate<Entity<Observer::AdaptiveSource<EntityListener>>>("adaptive", world, raw,
+    [&dispatcher](auto& entities) { entities.emplace_back(dispatcher); }, drain);
+
+  // Sweeps the dense table of all subscriptions instead of visiting the entities.
+  simulate<Entity<Observer::RegistrySource<EntityListener>>>("registry", world, raw,
+    [](auto& entities) { entities.emplace_back(); }, noFlush,
+    [](auto&) { Observer::Registry<EntityListener>::instance().notifyAll(&EntityListener::onChanged, 1); });
+}
+
+} // namespace Benchmark
@@ -0,0 +1,113 @@
+#include <array>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "erased.h"
+#include "observer.h"
+#include "perf.h"
+
+// A source of many listener interfaces emits notifications of randomly chosen
+// interfaces to a few listeners each. Fully templated notification loops are
+// compared with the loop shared by all notifications of ErasedContainer.
+
+namespace
+{
+
+constexpr std::size_t ChannelCount = 96;
+constexpr std::size_t ListenersPerChannel = 3;
+
+template <std::size_t I>
+class Channel {
+public:
+  virtual ~Channel() {}
+  virtual void onValue(int value, int channel) = 0;
+};
+
+template <class T_Sequence>
+struct Channels;
+
+template <std::size_t... Is>
+struct Channels<std::index_sequence<Is...>>
+{
+  //! Listener of all channels, one function overrides the functions of all of them.
+  class Receiver : public Observer::Listener<Channel<Is>...> {
+  public:
+    void onValue(int value, int channel) override { m_sum += value ^ channel; }
+
+  private:
+    long long m_sum = 0;
+  };
+
+  template <template<class> class T_Container>
+  class Station : public Observer::Source<T_Container, Channel<Is>...> {
+  public:
+    using Emit = void (*)(Station&, int);
+
+    //! Functions emitting a notification of each channel.
+    static std::array<Emit, sizeof...(Is)> emitters()
+    {
+      return { { &Station::emit<Is>... } };
+    }
+
+  private:
+    template <std::size_t I>
+    static void emit(Station& station, int value)
+    {
+      station.notify(&Channel<I>::onValue, int(value), int(I));
+    }
+  };
+};
+
+using AllChannels = Channels<std::make_index_sequence<ChannelCount>>;
+
+template <template<class> class T_Container>
+void run(const char* name, const std::vector<std::uint8_t>& sequence)
+{
+  std::vector<AllChannels::Receiver> receivers(ListenersPerChannel);
+  AllChannels::Station<T_Container> station;
+  for (auto& receiver : receivers)
+    station.attach(&receiver);
+  auto emitters = AllChannels::Station<T_Container>::emitters();
+
+  for (std::size_t i = 0; i < sequence.size() / 10; ++i)
+    emitters[sequence[i]](station, int(i));
+
+  Benchmark::PerfCounters counters;
+  Benchmark::Stopwatch stopwatch;
+  counters.start();
+  for (std::size_t i = 0; i < sequence.size(); ++i)
+    emitters[sequence[i]](station, int(i));
+  counters.stop();
+  double count = double(sequence.size());
+
+  std::printf("%-10s %12.2f %12s %12s\n", name, stopwatch.nanoseconds() / count,
+    counters.perItem(Benchmark::PerfCounters::L1InstructionMisses, count).c_str(),
+    counters.perItem(Benchmark::PerfCounters::L1DataMisses, count).c_str());
+}
+
+}
+
+namespace Benchmark
+{
+
+void erasedNotify(const Options& options)
+{
+  auto count = std::max<std::size_t>(static_cast<std::size_t>(5000000 * options.scale), 1);
+
+  printTitle("Type-erased notification loop: " + std::to_string(ChannelCount)
+    + " interfaces with " + std::to_string(ListenersPerChannel) + " listeners, random order");
+  std::printf("%-10s %12s %12s %12s\n", "container", "ns/notify", "L1I/notify", "L1D/notify");
+
+  std::mt19937 random(19);
+  std::vector<std::uint8_t> sequence(count);
+  for (auto& channel : sequence)
+    channel = static_cast<std::uint8_t>(random() % ChannelCount);
+
+  run<Observer::RawContainer>("raw", sequence);
+  run<Observer::ErasedContainer>("erased", sequence);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "executor.h"
+#include "observer.h"
+
+// Broadcasts to many listeners are delivered asynchronously, either by the
+// work-stealing Executor or by a thread pool with one central queue, to which
+// every chunk of as many listeners as in a task of the executor is posted.
+// Reported are listener calls per second.
+
+namespace
+{
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { m_sum.fetch_add(value, std::memory_order_relaxed); }
+
+private:
+  // Broadcasts in flight call a listener on several workers at once, padding avoids false sharing.
+  alignas(64) std::atomic<long long> m_sum{0};
+};
+
+class Ticker : public Observer::RawSource<TickListener> {
+public:
+  Observer::Completion tick(Observer::Executor& executor, int value)
+  {
+    return notifyAsync(executor, &TickListener::onTick, int(value));
+  }
+
+  //! Copy of the listeners, as taken by a broadcast of the executor.
+  std::vector<TickListener*> listeners()
+  {
+    std::vector<TickListener*> result;
+    forEachListener([&result](TickListener* listener) { result.push_back(listener); });
+    return result;
+  }
+};
+
+//! Listeners [begin, end) of a broadcast, which are called by one job of CentralPool.
+struct Chunk
+{
+  TickListener* const* begin;
+  TickListener* const* end;
+  int value;
+  std::atomic<std::size_t>* finished;
+
+  void operator()() const
+  {
+    for (auto* listener = begin; listener != end; ++listener)
+      (*listener)->onTick(value);
+    finished->fetch_add(std::size_t(end - begin), std::memory_order_relaxed);
+  }
+};
+
+//! The usual thread pool, whose workers share one queue guarded by a mutex.
+class CentralPool
+{
+public:
+  explicit CentralPool(std::size_t workers)
+  {
+    for (std::size_t i = 0; i < workers; ++i)
+      m_threads.emplace_back([this] { run(); });
+  }
+
+  ~CentralPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads)
+      thread.join();
+  }
+
+  void post(std::function<void()> job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+  }
+
+private:
+  void run()
+  {
+    for (;;)
+    {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+        if (m_jobs.empty())
+          return;
+        job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::deque<std::function<void()>> m_jobs;
+  bool m_stopping = false;
+  std::vector<std::thread> m_threads;
+};
+
+void printRate(const char* name, std::size_t listeners, double calls, double seconds)
+{
+  std::printf("%-14s %10zu %16.0f\n", name, listeners, calls / seconds);
+}
+
+}
+
+namespace Benchmark
+{
+
+void executorFanOut(const Options& options)
+{
+  auto calls = std::max<std::size_t>(static_cast<std::size_t>(4000000 * options.scale), 1);
+  auto workers = std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+
+  printTitle("Asynchronous broadcasts on " + std::to_string(workers) + " workers, listener calls per second");
+  std::printf("%-14s %10s %16s\n", "executor", "listeners", "calls/s");
+
+  for (std::size_t listenerCount : { 16, 256, 4096 })
+  {
+    std::vector<TickObserver> observers(listenerCount);
+    Ticker ticker;
+    for (auto& observer : observers)
+      ticker.attach(&observer);
+    auto broadcasts = std::max<std::size_t>(calls / listenerCount, 1);
+
+    {
+      Observer::Executor executor(workers);
+      std::vector<Observer::Completion> pending;
+      Stopwatch stopwatch;
+      for (std::size_t i = 0; i < broadcasts; ++i)
+      {
+        pending.push_back(ticker.tick(executor, static_cast<int>(i)));
+        // Keep a bounded number of broadcasts in flight.
+        if (pending.size() == 64)
+        {
+          for (auto& completion : pending)
+            completion.wait();
+          pending.clear();
+        }
+      }
+      for (auto& completion : pending)
+        completion.wait();
+      printRate("work-stealing", listenerCount, double(broadcasts * listenerCount), stopwatch.seconds());
+    }
+
+    {
+      std::atomic<std::size_t> finished(0);
+      // Broadcasts in flight, whose listeners and chunks must outlive the pool.
+      std::vector<std::vector<TickListener*>> listeners(64);
+      std::vector<std::vector<Chunk>> chunks(64);
+      Stopwatch stopwatch;
+      {
+        CentralPool pool(workers);
+        std::size_t posted = 0;
+        for (std::size_t i = 0; i < broadcasts; ++i)
+        {
+          const std::size_t slot = i % 64;
+          listeners[slot] = ticker.listeners();
+          const auto* first = listeners[slot].data();
+          chunks[slot].clear();
+          for (std::size_t begin = 0; begin < listenerCount; begin += Observer::Executor::DefaultGrain)
+          {
+            const std::size_t end = std::min(listenerCount, begin + Observer::Executor::DefaultGrain);
+            chunks[slot].push_back({ first + begin, first + end, static_cast<int>(i), &finished });
+          }
+          // The job captures just a pointer, so std::function stores it without allocating.
+          for (const auto& chunk : chunks[slot])
+            pool.post([chunk = &chunk] { (*chunk)(); });
+          posted += listenerCount;
+          if (slot == 63)
+            while (finished.load(std::memory_order_relaxed) != posted)
+              std::this_thread::yield();
+        }
+      }
+      printRate("central queue", listenerCount, double(broadcasts * listenerCount), stopwatch.seconds());
+    }
+  }
+}
+
+} // namespace Benchmark
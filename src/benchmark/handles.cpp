@@ -0,0 +1,125 @@
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+#include "perf.h"
+#include "pool.h"
+
+// Many sources share a small population of listeners, so the listeners and the
+// pool stay in cache and notifications are bound by the bandwidth needed to read
+// the listener arrays of the sources. Pointers and 32-bit handles are compared.
+
+namespace
+{
+
+class EntityListener {
+public:
+  virtual ~EntityListener() {}
+  virtual void onChanged(int value) = 0;
+};
+
+class EntityObserver : public Observer::Listener<EntityListener> {
+public:
+  void onChanged(int value) override { m_sum += value; }
+
+private:
+  long long m_sum = 0;
+};
+
+template <class T_Base>
+class Entity : public T_Base {
+public:
+  void changed(int value) { this->notify(&EntityListener::onChanged, int(value)); }
+};
+
+struct Setup
+{
+  std::size_t sources;
+  std::size_t listenersPerSource;
+  std::size_t population;
+  std::size_t passes;
+};
+
+template <class T_Entity, class T_Listeners>
+void run(const char* name, const Setup& setup, const T_Listeners& listeners)
+{
+  std::mt19937 random(11);
+  std::uniform_int_distribution<std::size_t> pick(0, listeners.size() - 1);
+
+  std::vector<T_Entity> entities(setup.sources);
+  for (auto& entity : entities)
+    for (std::size_t i = 0; i < setup.listenersPerSource; ++i)
+      entity.attach(listeners[pick(random)]);
+
+  Observer::MemoryUsage usage;
+  for (auto& entity : entities)
+  {
+    entity.shrink();
+    usage += entity.memoryUsage();
+  }
+  // Bytes of listener storage read by one notification, without the source object.
+  double arrayBytes = double(usage.bytesUsed - setup.sources * sizeof(T_Entity)) / setup.sources;
+
+  // Visit the sources in random order, so that the hardware prefetcher cannot
+  // hide the latency of fetching their arrays.
+  std::vector<std::uint32_t> order(setup.sources);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), random);
+
+  Benchmark::PerfCounters counters;
+  Benchmark::Stopwatch stopwatch;
+  counters.start();
+  for (std::size_t pass = 0; pass < setup.passes; ++pass)
+    for (auto index : order)
+      entities[index].changed(1);
+  counters.stop();
+  double seconds = stopwatch.seconds();
+
+  double notifications = double(setup.sources) * setup.passes;
+  double calls = notifications * setup.listenersPerSource;
+  std::printf("%-12s %11.1f %10.2f %11.2f %11.2f %10s %10s\n",
+    name, arrayBytes, seconds * 1e9 / calls, notifications * arrayBytes / seconds / 1e9,
+    double(usage.bytesReserved) / (1024.0 * 1024.0),
+    counters.perItem(Benchmark::PerfCounters::CacheMisses, notifications).c_str(),
+    counters.perItem(Benchmark::PerfCounters::L1DataMisses, notifications).c_str());
+}
+
+}
+
+namespace Benchmark
+{
+
+void handleBandwidth(const Options& options)
+{
+  Setup setup;
+  setup.sources = static_cast<std::size_t>(200000 * options.scale);
+  setup.listenersPerSource = 8;
+  setup.population = 4096;
+  setup.passes = 5;
+
+  printTitle("Listener handles: " + std::to_string(setup.sources) + " sources with "
+    + std::to_string(setup.listenersPerSource) + " of " + std::to_string(setup.population)
+    + " shared listeners");
+  std::printf("%-12s %11s %10s %11s %11s %10s %10s\n",
+    "container", "array B/src", "ns/call", "array GB/s", "total MiB", "LLC/notify", "L1D/notify");
+
+  std::vector<EntityObserver> observers(setup.population);
+  std::vector<EntityObserver*> raw;
+  for (auto& observer : observers)
+    raw.push_back(&observer);
+
+  std::vector<std::shared_ptr<EntityObserver>> smart;
+  for (std::size_t i = 0; i < setup.population; ++i)
+    smart.push_back(std::make_shared<EntityObserver>());
+
+  run<Entity<Observer::RawSource<EntityListener>>>("raw", setup, raw);
+  run<Entity<Observer::PoolSource<EntityListener>>>("pool", setup, raw);
+  run<Entity<Observer::SmartSource<EntityListener>>>("smart", setup, smart);
+  run<Entity<Observer::SmartPoolSource<EntityListener>>>("smart-pool", setup, smart);
+}
+
+} // namespace Benchmark
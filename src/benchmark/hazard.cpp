@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "epoch.h"
+#include "hazard.h"
+#include "observer.h"
+#include "rcu.h"
+
+// Reader threads notify a source shared with a writer thread, which keeps
+// replacing one of its listeners. In the mixed load one listener now and then
+// takes a millisecond. Copy-on-write arrays reclaimed by epochs are compared
+// with arrays protected by hazard pointers. The peak of retired arrays, which
+// have not been deleted yet, shows how much the slow listener holds back.
+
+namespace
+{
+
+constexpr std::size_t ListenerCount = 16;
+constexpr std::size_t SlowEvery = 200;
+const auto SlowDuration = std::chrono::milliseconds(1);
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+// Listeners are shared by all readers, so they only read their state.
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { Benchmark::doNotOptimize(m_weight * value); }
+
+private:
+  int m_weight = 3;
+};
+
+class SlowObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override
+  {
+    if (value % SlowEvery)
+      return;
+    auto until = Benchmark::Clock::now() + SlowDuration;
+    while (Benchmark::Clock::now() < until)
+      ;
+  }
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+template <class T_Source, class T_Domain>
+void run(const char* name, std::size_t readers, bool mixed, std::size_t count)
+{
+  auto& domain = T_Domain::global();
+  std::vector<TickObserver> observers(ListenerCount + 1);
+  SlowObserver slow;
+  Ticker<T_Source> ticker;
+  for (std::size_t i = 0; i < ListenerCount; ++i)
+    ticker.attach(&observers[i]);
+  if (mixed)
+    ticker.attach(&slow);
+
+  std::atomic<std::size_t> running(readers);
+  std::vector<double> nanoseconds(readers);
+  std::vector<std::thread> threads;
+  for (std::size_t r = 0; r < readers; ++r)
+  {
+    threads.emplace_back([&, r]
+    {
+      Benchmark::Stopwatch stopwatch;
+      for (std::size_t i = 0; i < count; ++i)
+        ticker.tick(static_cast<int>(i));
+      nanoseconds[r] = stopwatch.nanoseconds() / count;
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  std::size_t churns = 0, peak = 0;
+  Observer::Listener<TickListener>* attached = &observers[0];
+  Observer::Listener<TickListener>* spare = &observers[ListenerCount];
+  while (running.load(std::memory_order_acquire))
+  {
+    ticker.detach(attached);
+    ticker.attach(spare);
+    std::swap(attached, spare);
+    ++churns;
+    peak = std::max(peak, domain.pendingBytes());
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+  domain.collect();
+
+  double average = 0.0;
+  for (double ns : nanoseconds)
+    average += ns / readers;
+  std::printf("%-16s %-8s %8zu %12.2f %12zu %14.1f\n", name, mixed ? "mixed" : "fast",
+    readers, average, churns, peak / 1024.0);
+}
+
+}
+
+namespace Benchmark
+{
+
+void hazardReclamation(const Options& options)
+{
+  auto count = std::max<std::size_t>(static_cast<std::size_t>(200000 * options.scale), SlowEvery);
+  auto readers = std::max<std::size_t>(std::min<std::size_t>(std::thread::hardware_concurrency(), 8), 2) - 1;
+
+  printTitle("Epochs versus hazard pointers, " + std::to_string(ListenerCount)
+    + " fast listeners, mixed load adds one taking 1 ms every " + std::to_string(SlowEvery) + " notifications");
+  std::printf("%-16s %-8s %8s %12s %12s %14s\n", "reclamation", "load", "readers", "ns/notify", "churns", "peak KiB");
+
+  using Rcu = Observer::RcuSource<TickListener>;
+  using Hazard = Observer::HazardSource<TickListener>;
+  for (bool mixed : { false, true })
+  {
+    run<Rcu, Observer::EpochDomain>("epochs", readers, mixed, count);
+    run<Hazard, Observer::HazardDomain>("hazard pointers", readers, mixed, count);
+  }
+}
+
+} // namespace Benchmark
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "hybrid.h"
+#include "observer.h"
+
+// Calibration of HybridContainer. Every representation is measured for a range
+// of listener counts, both notifications and churn, i.e. replacing a random
+// listener. The crossover of the churn costs suggests the thresholds.
+
+namespace
+{
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { m_sum += value; }
+
+private:
+  long long m_sum = 0;
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+using Hybrid = Observer::HybridContainer<Observer::Listener<TickListener>>;
+
+struct Cost
+{
+  double notify;
+  double churn;
+};
+
+template <class T_Source>
+Cost measure(std::size_t count, std::size_t work)
+{
+  std::vector<TickObserver> observers(2 * count);
+  std::vector<Observer::Listener<TickListener>*> attached, spare;
+  for (std::size_t i = 0; i < observers.size(); ++i)
+    (i < count ? attached : spare).push_back(&observers[i]);
+
+  Ticker<T_Source> ticker;
+  for (auto* listener : attached)
+    ticker.attach(listener);
+
+  auto rounds = std::max<std::size_t>(work / count, 1);
+  ticker.tick(0);
+  Benchmark::Stopwatch stopwatch;
+  for (std::size_t round = 0; round < rounds; ++round)
+    ticker.tick(static_cast<int>(round));
+  double notify = stopwatch.nanoseconds() / (double(rounds) * count);
+
+  std::mt19937 random(17);
+  std::uniform_int_distribution<std::size_t> pick(0, count - 1);
+  auto churns = std::min<std::size_t>(work / 16, 20000);
+  stopwatch.restart();
+  for (std::size_t i = 0; i < churns; ++i)
+  {
+    auto index = pick(random);
+    ticker.detach(attached[index]);
+    ticker.attach(spare[index]);
+    std::swap(attached[index], spare[index]);
+  }
+  double churn = stopwatch.nanoseconds() / churns;
+  return { notify, churn };
+}
+
+}
+
+namespace Benchmark
+{
+
+void hybridCalibration(const Options& options)
+{
+  auto work = std::max<std::size_t>(static_cast<std::size_t>(2000000 * options.scale), 1);
+  const auto defaults = Hybrid::thresholds();
+
+  printTitle("Hybrid container calibration: ns per notified listener and per replaced listener");
+  std::printf("%9s %13s %13s %13s %13s %13s %13s\n", "listeners",
+    "inline ntf", "inline churn", "vector ntf", "vector churn", "indexed ntf", "indexed churn");
+
+  std::size_t crossover = 0;
+  for (std::size_t count : { 1, 2, 3, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384 })
+  {
+    std::printf("%9zu", count);
+
+    if (count <= Hybrid::InlineCapacity)
+    {
+      auto cost = measure<Observer::HybridSource<TickListener>>(count, work);
+      std::printf(" %13.2f %13.1f", cost.notify, cost.churn);
+    }
+    else
+    {
+      std::printf(" %13s %13s", "-", "-");
+    }
+
+    auto vector = measure<Observer::RawSource<TickListener>>(count, work);
+    std::printf(" %13.2f %13.1f", vector.notify, vector.churn);
+
+    if (count > Hybrid::InlineCapacity)
+    {
+      Observer::HybridThresholds indexed;
+      indexed.indexAbove = 0;
+      indexed.unindexBelow = 0;
+      indexed.inlineAtMost = 0;
+      Hybrid::setThresholds(indexed);
+      auto cost = measure<Observer::HybridSource<TickListener>>(count, work);
+      Hybrid::setThresholds(defaults);
+      std::printf(" %13.2f %13.1f", cost.notify, cost.churn);
+      if (!crossover && cost.churn < vector.churn)
+        crossover = count;
+    }
+    else
+    {
+      std::printf(" %13s %13s", "-", "-");
+    }
+    std::printf("\n");
+  }
+
+  if (crossover)
+    std::printf("suggested thresholds: indexAbove=%zu unindexBelow=%zu (defaults %zu and %zu)\n",
+      crossover, crossover / 4, defaults.indexAbove, defaults.unindexBelow);
+}
+
+} // namespace Benchmark
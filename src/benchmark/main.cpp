@@ -0,0 +1,95 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+namespace
+{
+
+struct Scenario
+{
+  const char* name;
+  const char* description;
+  void (*run)(const Benchmark::Options&);
+};
+
+const Scenario scenarios[] = {
+  { "queued-latency", "latency of queued notifications under mixed load", Benchmark::queuedLatency },
+  { "memory", "memory footprint of sources and its reduction by shrink()", Benchmark::memoryFootprint },
+  { "entities", "millions of sources with sparse listeners, all container types", Benchmark::entitySimulation },
+  { "handles", "bandwidth of 32-bit listener handles versus pointers", Benchmark::handleBandwidth },
+  { "prefetch", "prefetching of scattered listeners with cold and warm caches", Benchmark::prefetchDistance },
+  { "resolved", "calls resolved at attach time versus pointers to member functions", Benchmark::resolvedCalls },
+  { "compact", "notifications before and after sorting listeners by address", Benchmark::compaction },
+  { "compound", "compound events sent by notifyAll() versus separate notifications", Benchmark::compoundEvents },
+  { "hybrid", "calibration of thresholds of the hybrid container", Benchmark::hybridCalibration },
+  { "erased", "notifications sharing one type-erased loop versus templated loops", Benchmark::erasedNotify },
+  { "rcu", "copy-on-write listeners reclaimed by epochs under concurrent churn", Benchmark::rcuNotify },
+  { "hazard", "epochs versus hazard pointers with slow listeners", Benchmark::hazardReclamation },
+  { "seqlock", "a few listeners under a sequence lock versus copy-on-write", Benchmark::seqlockNotify },
+  { "striped", "striped locks versus copy-on-write under attach and detach churn", Benchmark::stripedChurn },
+  { "executor", "asynchronous broadcasts by work stealing versus a central queue", Benchmark::executorFanOut },
+  { "numa", "asynchronous broadcasts on the home nodes of listeners versus any node", Benchmark::numaPlacement },
+  { "confined", "thread-confined sources changed by other threads versus copy-on-write", Benchmark::confinedNotify },
+};
+
+void usage()
+{
+  std::cout << "usage: benchmark [--scale=<factor>] [scenario...]\n\nscenarios:\n";
+  for (const auto& scenario : scenarios)
+    std::cout << "  " << scenario.name << " - " << scenario.description << "\n";
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  Benchmark::Options options;
+  std::vector<std::string> selected;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg.compare(0, 8, "--scale=") == 0)
+      options.scale = std::atof(arg.c_str() + 8);
+    else if (arg == "--help" || arg == "-h")
+    {
+      usage();
+      return 0;
+    }
+    else
+      selected.push_back(arg);
+  }
+
+  if (options.scale <= 0.0)
+  {
+    usage();
+    return 1;
+  }
+
+  for (const auto& name : selected)
+  {
+    bool known = false;
+    for (const auto& scenario : scenarios)
+      known = known || name == scenario.name;
+    if (!known)
+    {
+      std::cerr << "unknown scenario: " << name << "\n";
+      usage();
+      return 1;
+    }
+  }
+
+  for (const auto& scenario : scenarios)
+  {
+    bool run = selected.empty();
+    for (const auto& name : selected)
+      run = run || name == scenario.name;
+    if (run)
+      scenario.run(options);
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+
+namespace
+{
+
+class EntityListener {
+public:
+  virtual ~EntityListener() {}
+  virtual void onChanged(int) = 0;
+};
+
+class EntityObserver : public Observer::Listener<EntityListener> {
+public:
+  void onChanged(int) override {}
+};
+
+void print(const char* container, const char* phase, const Observer::MemoryUsage& usage, std::size_t sources)
+{
+  std::printf("%-10s %-16s %12.1f %12.1f %10zu %10zu %10.1f\n",
+    container, phase,
+    double(usage.bytesUsed) / sources, double(usage.bytesReserved) / sources,
+    usage.liveEntries, usage.deadEntries,
+    usage.bytesReserved / (1024.0 * 1024.0));
+}
+
+template <class T_Source>
+Observer::MemoryUsage total(const std::vector<T_Source>& sources)
+{
+  Observer::MemoryUsage usage;
+  for (const auto& source : sources)
+    usage += source.memoryUsage();
+  return usage;
+}
+
+// Every source gets up to three listeners, some of which are detached again.
+// This leaves the capacity slack typical for sources with a history of churn.
+template <class T_Source, class T_Listener>
+void populate(std::vector<T_Source>& sources, const std::vector<T_Listener>& listeners)
+{
+  std::mt19937 random(42);
+  std::uniform_int_distribution<std::size_t> pick(0, listeners.size() - 1);
+  for (auto& source : sources)
+  {
+    std::size_t attached = random() % 4;
+    std::size_t detached = attached ? random() % (attached + 1) : 0;
+    std::vector<T_Listener> chosen;
+    for (std::size_t i = 0; i < attached; ++i)
+    {
+      chosen.push_back(listeners[pick(random)]);
+      source.attach(chosen.back());
+    }
+    for (std::size_t i = 0; i < detached; ++i)
+      source.detach(chosen[i]);
+  }
+}
+
+void raw(std::size_t count)
+{
+  std::vector<EntityObserver> observers(1024);
+  std::vector<EntityObserver*> listeners;
+  for (auto& observer : observers)
+    listeners.push_back(&observer);
+
+  std::vector<Observer::RawSource<EntityListener>> sources(count);
+  populate(sources, listeners);
+  print("raw", "after churn", total(sources), count);
+  for (auto& source : sources)
+    source.shrink();
+  print("raw", "after shrink", total(sources), count);
+}
+
+void smart(std::size_t count)
+{
+  std::vector<std::shared_ptr<EntityObserver>> listeners;
+  for (int i = 0; i < 1024; ++i)
+    listeners.push_back(std::make_shared<EntityObserver>());
+
+  std::vector<Observer::SmartSource<EntityListener>> sources(count);
+  populate(sources, listeners);
+  print("smart", "after churn", total(sources), count);
+
+  // Half of the listeners die without being detached.
+  for (std::size_t i = 0; i < listeners.size(); i += 2)
+    listeners[i].reset();
+  print("smart", "listeners died", total(sources), count);
+
+  for (auto& source : sources)
+    source.shrink();
+  print("smart", "after shrink", total(sources), count);
+}
+
+}
+
+namespace Benchmark
+{
+
+void memoryFootprint(const Options& options)
+{
+  auto count = static_cast<std::size_t>(1000000 * options.scale);
+  printTitle("Memory footprint of " + std::to_string(count) + " sources with 0-3 listeners");
+  std::printf("%-10s %-16s %12s %12s %10s %10s %10s\n",
+    "container", "phase", "used/src", "reserved/src", "live", "dead", "total MiB");
+  raw(count);
+  smart(count);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "benchmark.h"
+#include "numa.h"
+#include "observer.h"
+
+// Listeners owning a few cache lines of state are spread over the NUMA nodes
+// and allocated by a thread of their node. Broadcasts are delivered either on
+// the workers of the home node of every listener or by any worker. Reported
+// are listener calls per second and the share of calls run by a worker of
+// the home node. On a machine with a single node the nodes are simulated, so
+// only the share of local calls is meaningful.
+
+namespace
+{
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+class PlacedObserver : public Observer::Listener<TickListener> {
+public:
+  PlacedObserver(const Observer::Executor& executor, std::size_t home)
+    : m_executor(executor)
+    , m_home(home)
+  {}
+
+  void onTick(int value) override
+  {
+    for (auto& word : m_state)
+      word += value;
+    if (m_executor.currentGroup() == m_home)
+      ++m_localCalls;
+    ++m_calls;
+  }
+
+  std::size_t calls() const { return m_calls; }
+  std::size_t localCalls() const { return m_localCalls; }
+
+private:
+  const Observer::Executor& m_executor;
+  const std::size_t m_home;
+  std::size_t m_calls = 0;
+  std::size_t m_localCalls = 0;
+  long long m_state[32] = {};
+};
+
+class PlacedTicker : public Observer::NumaSource<TickListener> {
+public:
+  Observer::Completion tick(Observer::Executor& executor, int value)
+  {
+    return notifyAsync(executor, &TickListener::onTick, int(value));
+  }
+};
+
+class SpreadTicker : public Observer::RawSource<TickListener> {
+public:
+  Observer::Completion tick(Observer::Executor& executor, int value)
+  {
+    return notifyAsync(executor, &TickListener::onTick, int(value));
+  }
+};
+
+//! Run \a function on a thread pinned to \a cpus, so that it allocates memory of their node.
+template <class F>
+void runOn([[maybe_unused]] const std::vector<int>& cpus, F&& function)
+{
+  std::thread thread([&cpus, &function]
+  {
+#if defined(__linux__)
+    if (!cpus.empty())
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : cpus)
+      {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+          CPU_SET(cpu, &set);
+      }
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    function();
+  });
+  thread.join();
+}
+
+template <class T_Ticker>
+void measure(const char* name, T_Ticker& ticker, Observer::Executor& executor,
+  const std::vector<std::unique_ptr<PlacedObserver>>& observers, std::size_t broadcasts)
+{
+  Benchmark::Stopwatch stopwatch;
+  for (std::size_t i = 0; i < broadcasts; ++i)
+    ticker.tick(executor, static_cast<int>(i)).wait();
+  const double seconds = stopwatch.seconds();
+
+  std::size_t calls = 0;
+  std::size_t localCalls = 0;
+  for (const auto& observer : observers)
+  {
+    calls += observer->calls();
+    localCalls += observer->localCalls();
+  }
+  std::printf("%-10s %10zu %16.0f %9.1f%%\n", name, observers.size(), double(broadcasts * observers.size()) / seconds,
+    100.0 * double(localCalls) / double(std::max<std::size_t>(calls, 1)));
+}
+
+}
+
+namespace Benchmark
+{
+
+void numaPlacement(const Options& options)
+{
+  auto topology = Observer::NumaTopology::detect();
+  if (topology.nodeCount() < 2)
+    topology = Observer::NumaTopology::simulated(2);
+  const auto groups = topology.workerGroups();
+  std::size_t workers = 0;
+  for (const auto& group : groups)
+    workers += group.workers ? group.workers : group.cpus.size();
+
+  printTitle("Asynchronous broadcasts on " + std::to_string(topology.nodeCount())
+    + (topology.isSimulated() ? " simulated" : "") + " NUMA nodes with " + std::to_string(workers)
+    + " workers, listener calls per second");
+  std::printf("%-10s %10s %16s %10s\n", "delivery", "listeners", "calls/s", "local");
+
+  auto calls = std::max<std::size_t>(static_cast<std::size_t>(2000000 * options.scale), 1);
+  for (std::size_t listenerCount : { 256, 4096 })
+  {
+    Observer::Executor executor(groups);
+    const std::size_t perNode = std::max<std::size_t>(listenerCount / topology.nodeCount(), 1);
+    auto broadcasts = std::max<std::size_t>(calls / listenerCount, 1);
+
+    for (bool placed : { true, false })
+    {
+      std::vector<std::unique_ptr<PlacedObserver>> observers;
+      PlacedTicker placedTicker;
+      SpreadTicker spreadTicker;
+      for (std::size_t node = 0; node < topology.nodeCount(); ++node)
+      {
+        const auto& cpus = topology.nodes()[node].cpus;
+        runOn(cpus, [&]
+        {
+          for (std::size_t i = 0; i < perNode; ++i)
+            observers.push_back(std::make_unique<PlacedObserver>(executor, node));
+        });
+        for (std::size_t i = observers.size() - perNode; i < observers.size(); ++i)
+        {
+          placedTicker.attach(observers[i].get());
+          spreadTicker.attach(observers[i].get());
+          // Memory of a simulated node is not on a node of its own.
+          if (topology.isSimulated())
+            placedTicker.setHome(observers[i].get(), topology.nodes()[node].id);
+        }
+      }
+
+      if (placed)
+        measure("home node", placedTicker, executor, observers, broadcasts);
+      else
+        measure("any node", spreadTicker, executor, observers, broadcasts);
+    }
+  }
+}
+
+} // namespace Benchmark
@@ -0,0 +1,142 @@
+#ifndef OBSERVER_BENCHMARK_PERF_H
+#define OBSERVER_BENCHMARK_PERF_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Benchmark
+{
+
+//! Hardware event counters of the calling thread.
+/*!
+  Uses perf_event_open on Linux. Counters, which cannot be opened, e.g. in
+  virtual machines or when perf_event_paranoid forbids it, are reported as
+  unavailable and the benchmark prints "n/a" for them.
+*/
+class PerfCounters
+{
+public:
+  enum Event
+  {
+    CacheReferences,
+    CacheMisses,
+    L1DataMisses,
+    L1InstructionMisses,
+    EventCount
+  };
+
+  PerfCounters()
+  {
+    m_fds.fill(-1);
+#if defined(__linux__)
+    open(CacheReferences, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+    open(CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    open(L1DataMisses, PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D));
+    open(L1InstructionMisses, PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1I));
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters()
+  {
+#if defined(__linux__)
+    for (int fd : m_fds)
+      if (fd >= 0)
+        close(fd);
+#endif
+  }
+
+  //! Reset and start all counters.
+  void start()
+  {
+#if defined(__linux__)
+    for (int fd : m_fds)
+      if (fd >= 0)
+      {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+  }
+
+  //! Stop all counters and read their values.
+  void stop()
+  {
+#if defined(__linux__)
+    for (std::size_t i = 0; i < m_fds.size(); ++i)
+    {
+      m_values[i] = -1;
+      if (m_fds[i] < 0)
+        continue;
+      ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      std::uint64_t value = 0;
+      if (read(m_fds[i], &value, sizeof(value)) == sizeof(value))
+        m_values[i] = static_cast<std::int64_t>(value);
+    }
+#endif
+  }
+
+  //! Value of counter \a event, or -1 if the counter is not available.
+  std::int64_t value(Event event) const
+  {
+    return m_values[event];
+  }
+
+  //! Value of counter \a event divided by \a count formatted for a table.
+  std::string perItem(Event event, double count) const
+  {
+    if (m_values[event] < 0 || count <= 0)
+      return "n/a";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", m_values[event] / count);
+    return buffer;
+  }
+
+  //! Ratio of counters \a part and \a whole in percent formatted for a table.
+  std::string ratio(Event part, Event whole) const
+  {
+    if (m_values[part] < 0 || m_values[whole] <= 0)
+      return "n/a";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.1f%%", 100.0 * m_values[part] / m_values[whole]);
+    return buffer;
+  }
+
+private:
+#if defined(__linux__)
+  static std::uint64_t cacheConfig(std::uint64_t cache)
+  {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+  void open(Event event, std::uint32_t type, std::uint64_t config)
+  {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fds[event] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+
+  std::array<int, EventCount> m_fds;
+  std::array<std::int64_t, EventCount> m_values{ { -1, -1, -1, -1 } };
+};
+
+} // namespace Benchmark
+
+#endif // OBSERVER_BENCHMARK_PERF_H
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+#include "perf.h"
+#include "prefetch.h"
+
+// One source notifies listeners scattered in memory. With a cold cache every
+// listener and its virtual table is a miss, with a warm cache prefetching is
+// pure overhead. Both cases are measured for several prefetch distances.
+
+namespace
+{
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+//! Listener padded to two cache lines, several types for several virtual tables.
+template <int T_Kind>
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { m_sum += value * (T_Kind + 1); }
+
+private:
+  long long m_sum = 0;
+  char m_padding[112];
+};
+
+template <template<class> class T_Container>
+class Ticker : public Observer::Source<T_Container, TickListener> {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+//! Listeners of mixed types in memory order unrelated to the order of attachment.
+struct Population
+{
+  explicit Population(std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      switch (i % 4)
+      {
+      case 0: objects.push_back(std::make_unique<TickObserver<0>>()); break;
+      case 1: objects.push_back(std::make_unique<TickObserver<1>>()); break;
+      case 2: objects.push_back(std::make_unique<TickObserver<2>>()); break;
+      default: objects.push_back(std::make_unique<TickObserver<3>>()); break;
+      }
+      order.push_back(objects.back().get());
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(3));
+  }
+
+  std::vector<std::unique_ptr<Observer::Listener<TickListener>>> objects;
+  std::vector<Observer::Listener<TickListener>*> order;
+};
+
+//! Evicts the listeners from all cache levels by writing a large buffer.
+class Evictor
+{
+public:
+  Evictor() : m_buffer(64 << 20) {}
+
+  void operator()()
+  {
+    for (std::size_t i = 0; i < m_buffer.size(); i += 64)
+      m_buffer[i] = static_cast<char>(m_buffer[i] + 1);
+    Benchmark::doNotOptimize(m_buffer.front());
+  }
+
+private:
+  std::vector<char> m_buffer;
+};
+
+template <template<class> class T_Container>
+void run(const char* name, const Population& population, std::size_t rounds, const char* cache, Evictor* evict)
+{
+  Ticker<T_Container> ticker;
+  for (auto* listener : population.order)
+    ticker.attach(listener);
+
+  Benchmark::PerfCounters counters;
+  double seconds = 0;
+  std::int64_t misses = 0;
+  bool perfAvailable = true;
+  ticker.tick(0);
+  for (std::size_t round = 0; round < rounds; ++round)
+  {
+    if (evict)
+      (*evict)();
+    Benchmark::Stopwatch stopwatch;
+    counters.start();
+    ticker.tick(static_cast<int>(round));
+    counters.stop();
+    seconds += stopwatch.seconds();
+    auto value = counters.value(Benchmark::PerfCounters::L1DataMisses);
+    perfAvailable = perfAvailable && value >= 0;
+    misses += value;
+  }
+
+  double calls = double(population.order.size()) * rounds;
+  char missText[32] = "n/a";
+  if (perfAvailable)
+    std::snprintf(missText, sizeof(missText), "%.3f", misses / calls);
+  std::printf("%-12s %-5s %10zu %10.2f %12s\n",
+    name, cache, population.order.size(), seconds * 1e9 / calls, missText);
+}
+
+//! Evicts the cache before every round unless \a evict is null.
+void compare(const Population& population, std::size_t rounds, const char* cache, Evictor* evict)
+{
+  run<Observer::RawContainer>("raw", population, rounds, cache, evict);
+  run<Observer::Prefetching<2>::Container>("prefetch 2", population, rounds, cache, evict);
+  run<Observer::Prefetching<4>::Container>("prefetch 4", population, rounds, cache, evict);
+  run<Observer::Prefetching<8>::Container>("prefetch 8", population, rounds, cache, evict);
+  run<Observer::Prefetching<16>::Container>("prefetch 16", population, rounds, cache, evict);
+  run<Observer::Prefetching<32>::Container>("prefetch 32", population, rounds, cache, evict);
+}
+
+}
+
+namespace Benchmark
+{
+
+void prefetchDistance(const Options& options)
+{
+  auto small = std::max<std::size_t>(static_cast<std::size_t>(2000 * options.scale), 1);
+  auto large = std::max<std::size_t>(static_cast<std::size_t>(500000 * options.scale), 1);
+  auto rounds = std::max<std::size_t>(static_cast<std::size_t>(50 * options.scale), 1);
+
+  printTitle("Prefetching listeners: scattered listeners of 128 bytes, cold and warm caches");
+  std::printf("%-12s %-5s %10s %10s %12s\n", "container", "cache", "listeners", "ns/call", "L1D/call");
+
+  Evictor evict;
+  Population few(small);
+  compare(few, rounds * 20, "warm", nullptr);
+  compare(few, rounds, "cold", &evict);
+
+  // Does not fit in any cache, so every round is cold even without eviction.
+  Population many(large);
+  compare(many, 3, "large", nullptr);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,148 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "dispatcher.h"
+
+namespace
+{
+
+using Benchmark::Clock;
+
+class TimedListener {
+public:
+  virtual ~TimedListener() {}
+  virtual void onCritical(Clock::time_point postedAt) = 0;
+  virtual void onBulk(Clock::time_point postedAt) = 0;
+};
+
+class TimedSource : public Observer::QueuedSource<TimedListener> {
+public:
+  using QueuedSource::QueuedSource;
+
+  void critical() { notify(&TimedListener::onCritical, Clock::now()); }
+  void bulk() { notify(&TimedListener::onBulk, Clock::now()); }
+};
+
+// Records the time from posting to the start of the handler and then
+// simulates some work, so that the consumer is the bottleneck.
+class Recorder : public Observer::Listener<TimedListener> {
+public:
+  Benchmark::Samples critical;
+  Benchmark::Samples bulk;
+
+  void onCritical(Clock::time_point postedAt) override
+  {
+    critical.add(elapsed(postedAt));
+    work();
+  }
+
+  void onBulk(Clock::time_point postedAt) override
+  {
+    bulk.add(elapsed(postedAt));
+    work();
+  }
+
+private:
+  static double elapsed(Clock::time_point since)
+  {
+    return std::chrono::duration<double, std::micro>(Clock::now() - since).count();
+  }
+
+  static void work()
+  {
+    auto until = Clock::now() + std::chrono::nanoseconds(500);
+    while (Clock::now() < until)
+      ;
+  }
+};
+
+enum class Mode { SingleLane, Strict, Weighted };
+
+void run(const char* name, Mode mode, const Benchmark::Options& options)
+{
+  const auto duration = std::chrono::duration<double>(0.2 * options.scale);
+  const auto frame = std::chrono::milliseconds(1);
+  const std::size_t maxBacklog = 20000;
+
+  Observer::Dispatcher dispatcher;
+  Recorder recorder;
+  TimedSource source(dispatcher);
+  source.attach(&recorder);
+
+  if (mode != Mode::SingleLane)
+  {
+    source.setPriority(&TimedListener::onCritical, Observer::Priority::High);
+    source.setPriority(&TimedListener::onBulk, Observer::Priority::Low);
+  }
+  if (mode == Mode::Weighted)
+  {
+    dispatcher.setScheduling(Observer::Scheduling::Weighted);
+    dispatcher.setWeight(Observer::Priority::High, 8);
+    dispatcher.setWeight(Observer::Priority::Low, 1);
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 2; ++i)
+    producers.emplace_back([&]
+      {
+        while (!stop.load(std::memory_order_relaxed))
+          if (dispatcher.size() < maxBacklog)
+            source.bulk();
+          else
+            std::this_thread::yield();
+      });
+  producers.emplace_back([&]
+    {
+      while (!stop.load(std::memory_order_relaxed))
+      {
+        source.critical();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+
+  std::size_t dispatched = 0;
+  std::size_t frames = 0;
+  std::size_t overloadedFrames = 0;
+  Benchmark::Stopwatch stopwatch;
+  while (stopwatch.seconds() < duration.count())
+  {
+    auto report = dispatcher.drain(Clock::now() + frame);
+    dispatched += report.dispatched;
+    ++frames;
+    if (report.backlog() > 0)
+      ++overloadedFrames;
+  }
+  double seconds = stopwatch.seconds();
+
+  stop = true;
+  for (auto& producer : producers)
+    producer.join();
+  dispatcher.drain();
+
+  std::printf("%-12s %9.1f %9.1f %9.1f %11.1f %11.1f %10.0f %6zu/%zu\n",
+    name,
+    recorder.critical.percentile(50), recorder.critical.percentile(99), recorder.critical.max(),
+    recorder.bulk.percentile(50), recorder.bulk.percentile(99),
+    dispatched / seconds, overloadedFrames, frames);
+}
+
+}
+
+namespace Benchmark
+{
+
+void queuedLatency(const Options& options)
+{
+  printTitle("Queued notifications: post-to-handler latency under mixed load (us)");
+  std::printf("%-12s %9s %9s %9s %11s %11s %10s %s\n",
+    "lanes", "crit p50", "crit p99", "crit max", "bulk p50", "bulk p99", "events/s", "frames over budget");
+  run("single", Mode::SingleLane, options);
+  run("strict", Mode::Strict, options);
+  run("weighted", Mode::Weighted, options);
+}
+
+} // namespace Benchmark
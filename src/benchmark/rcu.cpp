@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "epoch.h"
+#include "observer.h"
+#include "rcu.h"
+
+// Reader threads notify a source shared with a writer thread, which keeps
+// replacing one of its listeners. The read side of RcuContainer is compared with
+// RawContainer, which cannot be changed while it is being notified, and the
+// guard per notification with one guard per frame of notifications.
+
+namespace
+{
+
+constexpr std::size_t ListenerCount = 16;
+constexpr std::size_t FrameLength = 256;
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+// Listeners are shared by all readers, so they only read their state.
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { Benchmark::doNotOptimize(m_weight * value); }
+
+private:
+  int m_weight = 3;
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+enum class Guarding { PerNotify, PerFrame };
+
+template <class T_Source>
+void run(const char* name, std::size_t readers, bool churn, Guarding guarding, std::size_t count)
+{
+  auto& domain = Observer::EpochDomain::global();
+  std::vector<TickObserver> observers(ListenerCount + 1);
+  Ticker<T_Source> ticker;
+  for (std::size_t i = 0; i < ListenerCount; ++i)
+    ticker.attach(&observers[i]);
+
+  std::atomic<std::size_t> running(readers);
+  std::vector<double> nanoseconds(readers);
+  std::vector<std::thread> threads;
+  for (std::size_t r = 0; r < readers; ++r)
+  {
+    threads.emplace_back([&, r]
+    {
+      Benchmark::Stopwatch stopwatch;
+      if (guarding == Guarding::PerFrame)
+      {
+        for (std::size_t i = 0; i < count; i += FrameLength)
+        {
+          Observer::EpochDomain::Guard frame(domain);
+          for (std::size_t j = i; j < std::min(i + FrameLength, count); ++j)
+            ticker.tick(static_cast<int>(j));
+          domain.quiescent();
+        }
+      }
+      else
+      {
+        for (std::size_t i = 0; i < count; ++i)
+          ticker.tick(static_cast<int>(i));
+      }
+      nanoseconds[r] = stopwatch.nanoseconds() / count;
+      domain.collect();
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  std::size_t churns = 0, peak = 0;
+  if (churn)
+  {
+    Observer::Listener<TickListener>* attached = &observers[0];
+    Observer::Listener<TickListener>* spare = &observers[ListenerCount];
+    while (running.load(std::memory_order_acquire))
+    {
+      ticker.detach(attached);
+      ticker.attach(spare);
+      std::swap(attached, spare);
+      ++churns;
+      peak = std::max(peak, domain.pendingBytes());
+    }
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  double average = 0.0;
+  for (double ns : nanoseconds)
+    average += ns / readers;
+  std::printf("%-24s %8zu %12.2f %12zu %14.1f\n", name, readers, average, churns, peak / 1024.0);
+}
+
+}
+
+namespace Benchmark
+{
+
+void rcuNotify(const Options& options)
+{
+  auto count = std::max<std::size_t>(static_cast<std::size_t>(2000000 * options.scale), FrameLength);
+  auto readers = std::max<std::size_t>(std::min<std::size_t>(std::thread::hardware_concurrency(), 8), 2) - 1;
+
+  printTitle("Copy-on-write container with epoch-based reclamation, "
+    + std::to_string(ListenerCount) + " listeners, reclaimer fences: "
+    + (Observer::EpochDomain::global().asymmetric() ? "membarrier" : "seq_cst on readers"));
+  std::printf("%-24s %8s %12s %12s %14s\n", "container", "readers", "ns/notify", "churns", "peak KiB");
+
+  using Raw = Observer::RawSource<TickListener>;
+  using Rcu = Observer::RcuSource<TickListener>;
+  run<Raw>("raw, no writer", readers, false, Guarding::PerNotify, count);
+  run<Rcu>("rcu, no writer", readers, false, Guarding::PerNotify, count);
+  run<Rcu>("rcu, guard per notify", readers, true, Guarding::PerNotify, count);
+  run<Rcu>("rcu, guard per frame", readers, true, Guarding::PerFrame, count);
+}
+
+} // namespace Benchmark
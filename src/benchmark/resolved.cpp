@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+#include "perf.h"
+#include "prefetch.h"
+#include "resolved.h"
+
+// One source notifies scattered listeners of several types. Calls through
+// pointers to member functions load every listener and its virtual table,
+// resolved calls read only the dense array of call targets.
+
+namespace
+{
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+//! Listener padded to two cache lines, several types for several virtual tables.
+template <int T_Kind>
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { m_sum += value * (T_Kind + 1); }
+
+private:
+  long long m_sum = 0;
+  char m_padding[112];
+};
+
+template <template<class> class T_Container>
+class Ticker : public Observer::Source<T_Container, TickListener> {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+//! Listeners of mixed types in memory order unrelated to the order of attachment.
+struct Population
+{
+  explicit Population(std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      switch (i % 4)
+      {
+      case 0: objects.push_back(std::make_unique<TickObserver<0>>()); break;
+      case 1: objects.push_back(std::make_unique<TickObserver<1>>()); break;
+      case 2: objects.push_back(std::make_unique<TickObserver<2>>()); break;
+      default: objects.push_back(std::make_unique<TickObserver<3>>()); break;
+      }
+      order.push_back(objects.back().get());
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(5));
+  }
+
+  std::vector<std::unique_ptr<Observer::Listener<TickListener>>> objects;
+  std::vector<Observer::Listener<TickListener>*> order;
+};
+
+template <template<class> class T_Container>
+void run(const char* name, const Population& population, std::size_t rounds)
+{
+  Ticker<T_Container> ticker;
+  for (auto* listener : population.order)
+    ticker.attach(listener);
+  // Builds the resolved calls, so that they are not measured.
+  ticker.tick(0);
+
+  Benchmark::PerfCounters counters;
+  Benchmark::Stopwatch stopwatch;
+  counters.start();
+  for (std::size_t round = 0; round < rounds; ++round)
+    ticker.tick(static_cast<int>(round));
+  counters.stop();
+  double seconds = stopwatch.seconds();
+
+  double calls = double(population.order.size()) * rounds;
+  std::printf("%-12s %10zu %10.2f %12s %12s\n",
+    name, population.order.size(), seconds * 1e9 / calls,
+    counters.perItem(Benchmark::PerfCounters::L1DataMisses, calls).c_str(),
+    counters.perItem(Benchmark::PerfCounters::L1InstructionMisses, calls).c_str());
+}
+
+void compare(const Population& population, std::size_t rounds)
+{
+  run<Observer::RawContainer>("raw", population, rounds);
+  run<Observer::Prefetching<Observer::DefaultPrefetchDistance>::Container>("prefetch 8", population, rounds);
+  run<Observer::ResolvedContainer>("resolved", population, rounds);
+}
+
+}
+
+namespace Benchmark
+{
+
+void resolvedCalls(const Options& options)
+{
+  auto small = std::max<std::size_t>(static_cast<std::size_t>(2000 * options.scale), 1);
+  auto large = std::max<std::size_t>(static_cast<std::size_t>(500000 * options.scale), 1);
+  auto rounds = std::max<std::size_t>(static_cast<std::size_t>(1000 * options.scale), 1);
+
+  printTitle(std::string("Resolved call targets: scattered listeners of 128 bytes")
+    + (OBSERVER_RESOLVED_CALLS ? "" : ", not supported by this compiler"));
+  std::printf("%-12s %10s %10s %12s %12s\n", "container", "listeners", "ns/call", "L1D/call", "L1I/call");
+
+  Population few(small);
+  compare(few, rounds);
+  Population many(large);
+  compare(many, 5);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+#include "rcu.h"
+#include "seqlock.h"
+
+// Reader threads notify a source of a few listeners, which a writer thread
+// replaces once a millisecond. The sequence lock is compared with the
+// copy-on-write container and with RawContainer, which is never changed.
+
+namespace
+{
+
+constexpr std::size_t ListenerCount = Observer::DefaultSeqlockCapacity - 1;
+const auto ChurnPeriod = std::chrono::milliseconds(1);
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+// Listeners are shared by all readers, so they only read their state.
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { Benchmark::doNotOptimize(m_weight * value); }
+
+private:
+  int m_weight = 3;
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+template <class T_Source>
+void run(const char* name, std::size_t readers, bool churn, std::size_t count)
+{
+  std::vector<TickObserver> observers(ListenerCount + 1);
+  Ticker<T_Source> ticker;
+  for (std::size_t i = 0; i < ListenerCount; ++i)
+    ticker.attach(&observers[i]);
+
+  std::atomic<std::size_t> running(readers);
+  std::vector<double> nanoseconds(readers);
+  std::vector<std::thread> threads;
+  for (std::size_t r = 0; r < readers; ++r)
+  {
+    threads.emplace_back([&, r]
+    {
+      Benchmark::Stopwatch stopwatch;
+      for (std::size_t i = 0; i < count; ++i)
+        ticker.tick(static_cast<int>(i));
+      nanoseconds[r] = stopwatch.nanoseconds() / count;
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  std::size_t churns = 0;
+  if (churn)
+  {
+    Observer::Listener<TickListener>* attached = &observers[0];
+    Observer::Listener<TickListener>* spare = &observers[ListenerCount];
+    while (running.load(std::memory_order_acquire))
+    {
+      ticker.detach(attached);
+      ticker.attach(spare);
+      std::swap(attached, spare);
+      ++churns;
+      std::this_thread::sleep_for(ChurnPeriod);
+    }
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  double average = 0.0;
+  for (double ns : nanoseconds)
+    average += ns / readers;
+  std::printf("%-10s %8zu %12.2f %12zu\n", name, readers, average, churns);
+}
+
+}
+
+namespace Benchmark
+{
+
+void seqlockNotify(const Options& options)
+{
+  auto count = std::max<std::size_t>(static_cast<std::size_t>(5000000 * options.scale), 1);
+  auto readers = std::max<std::size_t>(std::min<std::size_t>(std::thread::hardware_concurrency(), 8), 2) - 1;
+
+  printTitle("Sequence lock versus copy-on-write, " + std::to_string(ListenerCount)
+    + " listeners, one replaced every millisecond");
+  std::printf("%-10s %8s %12s %12s\n", "container", "readers", "ns/notify", "churns");
+
+  run<Observer::RawSource<TickListener>>("raw", readers, false, count);
+  run<Observer::RcuSource<TickListener>>("rcu", readers, true, count);
+  run<Observer::SeqlockSource<Observer::DefaultSeqlockCapacity, TickListener>>("seqlock", readers, true, count);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "observer.h"
+#include "rcu.h"
+#include "striped.h"
+
+// Threads share a source and each of them either notifies it or replaces one
+// of its own listeners, as connection tracking does. The striped container is
+// compared with the copy-on-write container for a range of shares of changes.
+
+namespace
+{
+
+constexpr std::size_t ListenersPerThread = 64;
+
+class TickListener {
+public:
+  virtual ~TickListener() {}
+  virtual void onTick(int value) = 0;
+};
+
+// Listeners are shared by all threads, so they only read their state.
+class TickObserver : public Observer::Listener<TickListener> {
+public:
+  void onTick(int value) override { Benchmark::doNotOptimize(m_weight * value); }
+
+private:
+  int m_weight = 3;
+};
+
+template <class T_Base>
+class Ticker : public T_Base {
+public:
+  void tick(int value) { this->notify(&TickListener::onTick, int(value)); }
+};
+
+template <class T_Source>
+double run(std::size_t threadCount, double changeShare, std::size_t operations)
+{
+  Ticker<T_Source> ticker;
+  std::vector<std::vector<TickObserver>> observers(threadCount);
+  for (auto& own : observers)
+  {
+    own.resize(2 * ListenersPerThread);
+    for (std::size_t i = 0; i < ListenersPerThread; ++i)
+      ticker.attach(&own[i]);
+  }
+
+  Benchmark::Stopwatch stopwatch;
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < threadCount; ++t)
+  {
+    threads.emplace_back([&, t]
+    {
+      std::vector<Observer::Listener<TickListener>*> attached, spare;
+      for (std::size_t i = 0; i < observers[t].size(); ++i)
+        (i < ListenersPerThread ? attached : spare).push_back(&observers[t][i]);
+
+      std::mt19937 random(static_cast<unsigned>(t));
+      std::uniform_real_distribution<double> share(0.0, 1.0);
+      std::uniform_int_distribution<std::size_t> pick(0, ListenersPerThread - 1);
+      for (std::size_t i = 0; i < operations; ++i)
+      {
+        if (share(random) < changeShare)
+        {
+          auto index = pick(random);
+          ticker.detach(attached[index]);
+          ticker.attach(spare[index]);
+          std::swap(attached[index], spare[index]);
+        }
+        else
+        {
+          ticker.tick(static_cast<int>(i));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  return threadCount * operations / stopwatch.seconds();
+}
+
+}
+
+namespace Benchmark
+{
+
+void stripedChurn(const Options& options)
+{
+  auto operations = std::max<std::size_t>(static_cast<std::size_t>(20000 * options.scale), 1);
+  auto threads = std::max<std::size_t>(std::min<std::size_t>(std::thread::hardware_concurrency(), 8), 2);
+
+  printTitle("Striped locks versus copy-on-write, " + std::to_string(threads) + " threads with "
+    + std::to_string(ListenersPerThread) + " listeners each, operations per second");
+  std::printf("%10s %14s %14s\n", "changes", "rcu", "striped");
+
+  for (double changeShare : { 0.0, 0.01, 0.1, 0.5, 0.9 })
+  {
+    auto rcu = run<Observer::RcuSource<TickListener>>(threads, changeShare, operations);
+    auto striped = run<Observer::StripedSource<Observer::DefaultStripeCount, TickListener>>(threads, changeShare, operations);
+    std::printf("%9.0f%% %14.0f %14.0f\n", 100 * changeShare, rcu, striped);
+  }
+}
+
+} // namespace Benchmark
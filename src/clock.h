@@ -0,0 +1,72 @@
+#ifndef OBSERVER_CLOCK_H
+#define OBSERVER_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+namespace Observer
+{
+
+//! A cheap clock for timestamps of individual events.
+/*!
+  On x86 the clock reads the time stamp counter, which takes a few nanoseconds,
+  elsewhere it falls back to std::chrono::steady_clock. Ticks are converted to
+  nanoseconds by a factor, which is calibrated once on first use. The counter is
+  assumed to be invariant and synchronized among cores, which holds for all
+  current x86 processors.
+*/
+class TscClock
+{
+public:
+  //! Current value of the counter in ticks.
+  static std::uint64_t now()
+  {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  //! Duration of one tick in nanoseconds.
+  static double nanosecondsPerTick()
+  {
+    static const double factor = calibrate();
+    return factor;
+  }
+
+  //! Convert a number of \a ticks to nanoseconds.
+  static double toNanoseconds(std::uint64_t ticks)
+  {
+    return ticks * nanosecondsPerTick();
+  }
+
+private:
+  static double calibrate()
+  {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto ticks = now();
+    while (Clock::now() - start < std::chrono::milliseconds(5))
+      ;
+    auto elapsedTicks = now() - ticks;
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return elapsedTicks ? elapsed / elapsedTicks : 1.0;
+#else
+    return 1.0;
+#endif
+  }
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_CLOCK_H
@@ -0,0 +1,293 @@
+#ifndef OBSERVER_COMPLETION_H
+#define OBSERVER_COMPLETION_H
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define OBSERVER_COROUTINES 1
+#endif
+#endif
+
+#ifndef OBSERVER_COROUTINES
+#define OBSERVER_COROUTINES 0
+#endif
+
+namespace Observer
+{
+
+namespace detail
+{
+//! Mutexes and condition variables shared by all threads waiting for an address.
+/*!
+  Waiting for a rare event does not justify a mutex in every object, so
+  waiters block on one of a few buckets chosen by the address they wait for.
+*/
+class ParkingLot
+{
+public:
+  //! Block until \a ready returns true, it is checked with the bucket of \a address locked.
+  template <class F>
+  static void wait(const void* address, F&& ready)
+  {
+    Bucket& bucket = bucketOf(address);
+    std::unique_lock<std::mutex> lock(bucket.mutex);
+    bucket.wake.wait(lock, std::forward<F>(ready));
+  }
+
+  //! Wake all threads waiting for \a address and others sharing its bucket.
+  static void notifyAll(const void* address)
+  {
+    Bucket& bucket = bucketOf(address);
+    {
+      std::lock_guard<std::mutex> lock(bucket.mutex);
+    }
+    bucket.wake.notify_all();
+  }
+
+private:
+  static constexpr std::size_t BucketCount = 16;
+
+  struct alignas(64) Bucket
+  {
+    std::mutex mutex;
+    std::condition_variable wake;
+  };
+
+  static Bucket& bucketOf(const void* address)
+  {
+    static Bucket buckets[BucketCount];
+    auto hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(address) >> 6) * 0x9E3779B97F4A7C15ull;
+    return buckets[(hash >> 32) % BucketCount];
+  }
+};
+
+//! State of an asynchronous broadcast shared by its tasks and its Completion handles.
+/*!
+  It is the header of the memory of the broadcast, so neither the handles nor
+  waiting for the broadcast allocate.
+*/
+struct AsyncState
+{
+  //! Space for the callback of Completion::then().
+  static constexpr std::size_t CallbackSize = 3 * sizeof(void*);
+
+  // Tasks, which have not finished yet.
+  std::atomic<std::size_t> remaining{0};
+  // Completion handles plus one held by the tasks until the last of them finishes.
+  std::atomic<std::size_t> references{1};
+  // Threads blocked in Completion::wait().
+  std::atomic<std::uint32_t> waiters{0};
+  // NoCallback, Subscribing, CallbackSet or Finished.
+  std::atomic<std::uint32_t> callbackState{NoCallback};
+  void (*callback)(void* storage) = nullptr;
+  alignas(std::max_align_t) unsigned char callbackStorage[CallbackSize];
+  void (*destroy)(AsyncState* state) = nullptr;
+
+  enum : std::uint32_t { NoCallback, Subscribing, CallbackSet, Finished };
+
+  void retain()
+  {
+    references.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release()
+  {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      destroy(this);
+  }
+
+  //! Called by every task of the broadcast when it has finished.
+  void finishTask()
+  {
+    if (remaining.fetch_sub(1, std::memory_order_seq_cst) != 1)
+      return;
+
+    // A callback still being stored is left to its subscriber, which sees Finished.
+    if (callbackState.exchange(Finished, std::memory_order_acq_rel) == CallbackSet)
+      callback(callbackStorage);
+    if (waiters.load(std::memory_order_seq_cst))
+      ParkingLot::notifyAll(this);
+    release();
+  }
+
+  //! Store \a function to be called when the broadcast finishes.
+  /*!
+    Returns false without storing it, if the broadcast has already finished.
+    The storage is claimed before it is written, so a second callback, e.g. of
+    then() on a copy of the handle, terminates the program instead of
+    overwriting the first one.
+  */
+  template <class F>
+  bool subscribe(F&& function)
+  {
+    using Function = std::decay_t<F>;
+    static_assert(sizeof(Function) <= CallbackSize && alignof(Function) <= alignof(std::max_align_t),
+      "The callback must be small, capture a pointer to larger state");
+
+    std::uint32_t expected = NoCallback;
+    if (!callbackState.compare_exchange_strong(expected, Subscribing, std::memory_order_acquire))
+    {
+      if (expected == Finished)
+        return false;
+      assert(!"A broadcast accepts one callback only");
+      std::terminate();
+    }
+
+    new (callbackStorage) Function(std::forward<F>(function));
+    callback = [](void* storage)
+    {
+      auto& stored = *static_cast<Function*>(storage);
+      stored();
+      stored.~Function();
+    };
+
+    expected = Subscribing;
+    if (callbackState.compare_exchange_strong(expected, CallbackSet, std::memory_order_acq_rel))
+      return true;
+
+    // The broadcast finished while the callback was being stored.
+    static_cast<Function*>(static_cast<void*>(callbackStorage))->~Function();
+    return false;
+  }
+
+  //! Block the calling thread until the broadcast finishes.
+  /*!
+    A worker of an Executor runs tasks of its executor meanwhile, which may be
+    the ones waited for, so a listener may wait for a broadcast it has made.
+  */
+  void wait()
+  {
+    if (t_help)
+    {
+      while (remaining.load(std::memory_order_acquire) != 0)
+      {
+        if (!t_help(t_helpContext))
+          std::this_thread::yield();
+      }
+      return;
+    }
+
+    // Broadcasts are usually short, so spin for a while before blocking.
+    for (int i = 0; i < 128; ++i)
+    {
+      if (remaining.load(std::memory_order_acquire) == 0)
+        return;
+      if (i >= 64)
+        std::this_thread::yield();
+    }
+
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    ParkingLot::wait(this, [this] { return remaining.load(std::memory_order_seq_cst) == 0; });
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  //! Set by a worker of an Executor to run one of its tasks, returns false if there was none.
+  static inline thread_local bool (*t_help)(void* context) = nullptr;
+  static inline thread_local void* t_helpContext = nullptr;
+};
+}
+
+//! Handle of an asynchronous notification, see Executor::broadcast().
+/*!
+  The handle shares the memory of the notification, so it does not allocate.
+  A default constructed handle refers to a notification, which is done.
+
+  The notification is done, when all listeners have returned. Then the
+  callback given to then() is called and threads in wait() are woken up.
+  In C++20 the handle is also awaitable by co_await.
+*/
+class Completion
+{
+public:
+  Completion() = default;
+
+  explicit Completion(detail::AsyncState* state)
+    : m_state(state)
+  {
+    if (m_state)
+      m_state->retain();
+  }
+
+  Completion(const Completion& other)
+    : Completion(other.m_state)
+  {}
+
+  Completion(Completion&& other) noexcept
+    : m_state(std::exchange(other.m_state, nullptr))
+  {}
+
+  Completion& operator=(Completion other) noexcept
+  {
+    std::swap(m_state, other.m_state);
+    return *this;
+  }
+
+  ~Completion()
+  {
+    if (m_state)
+      m_state->release();
+  }
+
+  //! True if all listeners have returned from the notification.
+  bool done() const
+  {
+    return !m_state || m_state->remaining.load(std::memory_order_acquire) == 0;
+  }
+
+  //! Block until all listeners have returned from the notification.
+  void wait() const
+  {
+    if (m_state)
+      m_state->wait();
+  }
+
+  //! Call \a function once all listeners have returned from the notification.
+  /*!
+    The function is called by the worker, which finished the notification, or
+    right away by the calling thread, if the notification is already done.
+    A notification accepts one function, which must not be larger than
+    detail::AsyncState::CallbackSize and must not throw. Calling then() or
+    co_await a second time, even on a copy of the handle, terminates the
+    program, unless the notification is already done.
+  */
+  template <class F>
+  void then(F function) const
+  {
+    if (!m_state || !m_state->subscribe(function))
+      function();
+  }
+
+#if OBSERVER_COROUTINES
+  //! Awaitable interface, a coroutine is resumed by the worker, which finished the notification.
+  bool await_ready() const noexcept
+  {
+    return done();
+  }
+
+  bool await_suspend(std::coroutine_handle<> coroutine)
+  {
+    return m_state->subscribe([coroutine] { coroutine.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+#endif
+
+private:
+  detail::AsyncState* m_state = nullptr;
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_COMPLETION_H
@@ -0,0 +1,320 @@
+#ifndef OBSERVER_CONFINED_H
+#define OBSERVER_CONFINED_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "completion.h"
+#include "observer.h"
+#include "queue.h"
+
+namespace Observer
+{
+
+namespace detail
+{
+//! State of a Completion, which is done when \a changes changes posted to ConfinedContainers are published.
+inline AsyncState* newPublishState(std::size_t changes)
+{
+  auto* state = new AsyncState;
+  state->remaining.store(changes, std::memory_order_relaxed);
+  state->destroy = [](AsyncState* s) { delete s; };
+  return state;
+}
+}
+
+//! A container of listeners owned by one thread, which other threads may post changes to.
+/*!
+  The thread, which constructs the container, or the last one calling
+  adopt(), is its owner. Only the owner may notify and the owner attaches and
+  detaches listeners right away, without any synchronization, so its
+  notifications cost as much as those of RawContainer.
+
+  attach() and detach() called by other threads are posted to a lock-free
+  queue and take effect, in the order they were posted, when the owner calls
+  publish() or its next notification. A listener detached by another thread
+  may be notified until then, so it must not be destroyed before the owner
+  has published the change. detachAsync() returns a Completion, which is done
+  at that point, e.g. a listener destroyed on another thread waits for it in
+  its destructor. Meanwhile the owner must keep publishing or notifying.
+
+  Debug builds assert that notifications and other methods meant for the
+  owner are called by the owner.
+*/
+template <class T_Listener>
+class ConfinedContainer
+{
+public:
+  ConfinedContainer()
+    : m_owner(std::this_thread::get_id())
+  {}
+
+  ConfinedContainer(const ConfinedContainer&) = delete;
+  ConfinedContainer& operator=(const ConfinedContainer&) = delete;
+
+  virtual ~ConfinedContainer()
+  {
+    // Threads waiting for changes, which were never published, are released.
+    Change change;
+    while (m_posted.pop(change))
+    {
+      if (change.published)
+        change.published->finishTask();
+    }
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener. If called by
+    another thread than the owner, the listener is attached by publish().
+  */
+  void attach(T_Listener* listener)
+  {
+    assert(listener);
+    if (!isOwner())
+    {
+      m_posted.push(Change{ listener, true });
+      return;
+    }
+    m_listeners.push_back(listener);
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore. If
+    called by another thread than the owner, the listener is detached by
+    publish().
+  */
+  void detach(T_Listener* listener)
+  {
+    if (!isOwner())
+    {
+      m_posted.push(Change{ listener, false });
+      return;
+    }
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+  }
+
+  //! Detach listener \a listener, returns a handle, which is done once it is detached.
+  /*!
+    Called by another thread than the owner, the handle is done when publish()
+    has detached the listener, so that no notification calls it anymore and
+    it may be destroyed. Called by the owner, the listener is detached right away.
+  */
+  Completion detachAsync(T_Listener* listener)
+  {
+    if (isOwner())
+    {
+      detach(listener);
+      return Completion();
+    }
+    auto* state = detail::newPublishState(1);
+    Completion completion(state);
+    m_posted.push(Change{ listener, false, state });
+    return completion;
+  }
+
+  //! Apply attach() and detach() posted by other threads. Only the owner may call this.
+  void publish()
+  {
+    assert(isOwner() && "Only the owner thread may publish changes of a ConfinedContainer");
+    Change change;
+    while (m_posted.pop(change))
+    {
+      if (change.attach)
+        attach(change.listener);
+      else
+        detach(change.listener);
+      if (change.published)
+        change.published->finishTask();
+    }
+  }
+
+  //! Make the calling thread the owner.
+  /*!
+    The previous owner must not use the container anymore, e.g. the container
+    is handed over to a thread together with the object owning it.
+  */
+  void adopt()
+  {
+    m_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  }
+
+  //! True if the calling thread is the owner.
+  bool isOwner() const
+  {
+    return std::this_thread::get_id() == m_owner.load(std::memory_order_relaxed);
+  }
+
+  //! Memory occupied by this container, without changes, which have not been published yet.
+  MemoryUsage memoryUsage() const
+  {
+    assert(isOwner());
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    usage.liveEntries = m_listeners.size();
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    assert(isOwner());
+    m_listeners.shrink_to_fit();
+  }
+
+  //! Sort listeners by their address, see RawContainer::compact().
+  void compact()
+  {
+    assert(isOwner());
+    std::sort(m_listeners.begin(), m_listeners.end(), std::less<T_Listener*>());
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    Changes posted by other threads are published first, then all listeners
+    registered in this container are notified. The parameter pack is
+    forwarded to that function. Only the owner may notify.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    assert(isOwner() && "Only the owner thread may notify a ConfinedContainer");
+    if (!m_posted.empty())
+      publish();
+
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* l : m_listeners)
+        detail::CallMonitor::timedCall(monitor, l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto* l : m_listeners)
+      (l->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+  //! Send all notifications \a calls to every listener before moving to the next one.
+  template <class... T_Calls>
+  void notifyAll(const T_Calls&... calls)
+  {
+    assert(isOwner() && "Only the owner thread may notify a ConfinedContainer");
+    if (!m_posted.empty())
+      publish();
+
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* l : m_listeners)
+        (calls.apply([monitor, l](auto fn, auto&&... args)
+          { detail::CallMonitor::timedCall(monitor, l, fn, std::forward<decltype(args)>(args)...); }), ...);
+      return;
+    }
+
+    for (auto* l : m_listeners)
+      (calls(l), ...);
+  }
+
+  //! Call \a function for every listener, see Source::notifyAsync().
+  template <class F>
+  void forEachListener(F&& function)
+  {
+    assert(isOwner() && "Only the owner thread may notify a ConfinedContainer");
+    if (!m_posted.empty())
+      publish();
+
+    for (auto* l : m_listeners)
+      function(l);
+  }
+
+  //! Detach listener \a listener and finish one task of \a state once it is detached, see detachAsync().
+  void detachAsync(T_Listener* listener, detail::AsyncState* state)
+  {
+    if (!isOwner())
+    {
+      m_posted.push(Change{ listener, false, state });
+      return;
+    }
+    detach(listener);
+    state->finishTask();
+  }
+
+private:
+  //! An attach() or detach() posted by another thread.
+  struct Change
+  {
+    T_Listener* listener = nullptr;
+    bool attach = false;
+    // Finished, when the change is published, see detachAsync().
+    detail::AsyncState* published = nullptr;
+  };
+
+  std::vector<T_Listener*> m_listeners;
+  std::atomic<std::thread::id> m_owner;
+  detail::MpscQueue<Change> m_posted;
+};
+
+//! A source owned by one thread, see ConfinedContainer.
+template <class... T_Listeners>
+class ConfinedSource
+  : public Source<ConfinedContainer, T_Listeners...>
+{
+public:
+  //! Apply attach() and detach() posted by other threads to containers of all listener types.
+  void publish()
+  {
+    (ConfinedContainer<T_Listeners>::publish(), ...);
+  }
+
+  //! Detach a listener object from containers of all its listener types, see ConfinedContainer::detachAsync().
+  /*!
+    The returned handle is done, when the owner has published the change to
+    every container, so that the listener may be destroyed.
+  */
+  template <class... Args>
+  Completion detachAsync(Listener<Args...>* listener)
+  {
+    constexpr std::size_t count = (std::size_t(ListenerSet::template contains<Args>) + ... + 0);
+    if constexpr (count == 0)
+      return Completion();
+    else
+    {
+      auto* state = detail::newPublishState(count);
+      Completion completion(state);
+      (detachAsyncFrom<Args>(listener, state), ...);
+      return completion;
+    }
+  }
+
+  //! Make the calling thread the owner of containers of all listener types.
+  void adopt()
+  {
+    (ConfinedContainer<T_Listeners>::adopt(), ...);
+  }
+
+  //! True if the calling thread is the owner.
+  bool isOwner() const
+  {
+    return (ConfinedContainer<T_Listeners>::isOwner() && ...);
+  }
+
+private:
+  using ListenerSet = detail::TypeSet<T_Listeners...>;
+
+  //! Detach \a listener from the container of \a T if this source supports \a T.
+  template <class T>
+  void detachAsyncFrom(T* listener, detail::AsyncState* state)
+  {
+    if constexpr (ListenerSet::template contains<T>)
+      ConfinedContainer<T>::detachAsync(listener, state);
+  }
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_CONFINED_H
@@ -0,0 +1,679 @@
+#ifndef OBSERVER_DISPATCHER_H
+#define OBSERVER_DISPATCHER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "clock.h"
+#include "observer.h"
+#include "queue.h"
+
+namespace Observer
+{
+
+//! Priority lanes of a Dispatcher.
+/*!
+  Lanes are listed from the most urgent to the least urgent one.
+*/
+enum class Priority
+{
+  High,
+  Normal,
+  Low
+};
+
+//! Number of priority lanes of a Dispatcher.
+constexpr std::size_t PriorityCount = 3;
+
+//! Result of a Dispatcher::drain() call.
+struct DrainReport
+{
+  //! Number of events dispatched by the call.
+  std::size_t dispatched = 0;
+  //! Number of events left behind in each lane, indexed by Priority.
+  std::array<std::size_t, PriorityCount> remaining{};
+  //! True if the call returned because the deadline was reached.
+  bool deadlineReached = false;
+
+  //! Total number of events left behind in all lanes.
+  std::size_t backlog() const
+  {
+    std::size_t total = 0;
+    for (auto count : remaining)
+      total += count;
+    return total;
+  }
+};
+
+//! Order, in which a Dispatcher takes events from its lanes.
+enum class Scheduling
+{
+  //! An event is taken from a lane only if all more urgent lanes are empty.
+  Strict,
+  //! Lanes are served in rounds. Each lane may dispatch as many events per round
+  //! as is its weight, so less urgent lanes are never starved.
+  Weighted
+};
+
+//! Receiver of latencies of queued notifications, see LatencyTracker.
+/*!
+  All durations are given in ticks of TscClock.
+*/
+class LatencyRecorder
+{
+public:
+  virtual ~LatencyRecorder() {}
+
+  //! Record an event of lane \a lane, which waited \a waitTicks in the queue
+  //! and whose dispatch took \a handlerTicks.
+  virtual void recordEvent(Priority lane, std::uint64_t waitTicks, std::uint64_t handlerTicks) = 0;
+
+  //! Record a call of \a listener of type \a listenerType attached to \a source.
+  /*!
+    The call started \a waitTicks after the notification was posted and took
+    \a handlerTicks.
+  */
+  virtual void recordCall(const void* source, const void* listener, const std::type_info& listenerType,
+    std::uint64_t waitTicks, std::uint64_t handlerTicks) = 0;
+
+  //! Drop calls recorded for \a listener, which has been detached from \a source.
+  virtual void forget(const void* /*source*/, const void* /*listener*/) {}
+};
+
+//! A queue of deferred notifications.
+/*!
+  Queued sources do not call their listeners directly. Instead, every
+  notification is posted to a dispatcher, which calls the listeners later
+  when drain() is invoked, typically once per frame of a render loop.
+
+  Events are kept in separate lanes, one per Priority. Each lane is a lock-free
+  queue, so events may be posted from any thread, while drain() must always be
+  called from one thread at a time. With Scheduling::Strict, drain always takes
+  the oldest event of the most urgent non-empty lane, so urgent events overtake
+  a backlog of less important ones. Scheduling::Weighted shares the dispatch
+  capacity among lanes according to their weights.
+
+  When a LatencyRecorder is set, every event is stamped by TscClock when posted,
+  and the time spent in the queue and in the handlers is recorded.
+*/
+class Dispatcher
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using Event = std::function<void()>;
+
+  //! Post \a event to the lane given by \a priority. May be called from any thread.
+  /*!
+    Returns false if the event was dropped because the lane is full.
+  */
+  template <class Fn>
+  bool post(Priority priority, Fn&& event)
+  {
+    auto& lane = m_lanes[static_cast<std::size_t>(priority)];
+    if (lane.size.fetch_add(1, std::memory_order_relaxed) >= lane.capacity.load(std::memory_order_relaxed))
+    {
+      lane.size.fetch_sub(1, std::memory_order_relaxed);
+      lane.dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    auto postedAt = m_recorder.load(std::memory_order_relaxed) ? TscClock::now() : 0;
+    lane.queue.push(Slot{ Event(std::forward<Fn>(event)), postedAt });
+    return true;
+  }
+
+  //! Set the maximum number of events waiting in lane \a priority.
+  /*!
+    Events posted to a full lane are dropped. Lanes are not limited by default.
+  */
+  void setCapacity(Priority priority, std::size_t capacity)
+  {
+    m_lanes[static_cast<std::size_t>(priority)].capacity.store(capacity, std::memory_order_relaxed);
+  }
+
+  //! Number of events dropped so far, because lane \a priority was full.
+  std::size_t dropped(Priority priority) const
+  {
+    return m_lanes[static_cast<std::size_t>(priority)].dropped.load(std::memory_order_relaxed);
+  }
+
+  //! Set the receiver of latencies of dispatched events, nullptr disables recording.
+  void setLatencyRecorder(LatencyRecorder* recorder)
+  {
+    m_recorder.store(recorder, std::memory_order_relaxed);
+  }
+
+  //! The receiver of latencies, which is used when dispatching the current event.
+  /*!
+    Returns nullptr if latencies are not recorded or the current event was posted
+    without a timestamp. May be called only from a handler of an event.
+  */
+  LatencyRecorder* latencyRecorder() const
+  {
+    return m_postedAt ? m_recorder.load(std::memory_order_relaxed) : nullptr;
+  }
+
+  //! The receiver set by setLatencyRecorder(), which may be called outside of event handlers.
+  LatencyRecorder* installedLatencyRecorder() const
+  {
+    return m_recorder.load(std::memory_order_relaxed);
+  }
+
+  //! The TscClock timestamp, at which the event being dispatched was posted.
+  std::uint64_t postedAt() const
+  {
+    return m_postedAt;
+  }
+
+  //! Set the order, in which lanes are drained.
+  void setScheduling(Scheduling scheduling)
+  {
+    m_scheduling = scheduling;
+  }
+
+  //! Set the number of events, which lane \a priority may dispatch in one round
+  //! of Scheduling::Weighted.
+  void setWeight(Priority priority, std::size_t weight)
+  {
+    assert(weight > 0);
+    m_lanes[static_cast<std::size_t>(priority)].weight = weight;
+  }
+
+  //! Dispatch queued events until the queue is empty or \a deadline is reached.
+  /*!
+    Reading the clock is not free, so the deadline is checked only once every
+    \a checkInterval events. The call may therefore overrun the deadline
+    by up to \a checkInterval - 1 events. Events, which were not dispatched,
+    stay in the queue for the next call.
+  */
+  DrainReport drain(Clock::time_point deadline, std::size_t checkInterval = 16)
+  {
+    assert(checkInterval > 0);
+    DrainReport report;
+    std::size_t untilCheck = 0;
+    Slot slot;
+    std::size_t lane = 0;
+    for (;;)
+    {
+      if (untilCheck-- == 0)
+      {
+        if (Clock::now() >= deadline)
+        {
+          report.deadlineReached = true;
+          break;
+        }
+        untilCheck = checkInterval - 1;
+      }
+      if (!next(slot, lane))
+        break;
+      dispatch(slot, lane);
+      ++report.dispatched;
+    }
+    fillRemaining(report);
+    return report;
+  }
+
+  //! Dispatch all queued events regardless of time.
+  DrainReport drain()
+  {
+    DrainReport report;
+    Slot slot;
+    std::size_t lane = 0;
+    while (next(slot, lane))
+    {
+      dispatch(slot, lane);
+      ++report.dispatched;
+    }
+    fillRemaining(report);
+    return report;
+  }
+
+  //! Number of events waiting in the queue.
+  std::size_t size() const
+  {
+    std::size_t total = 0;
+    for (const auto& lane : m_lanes)
+      total += lane.size.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  //! Returns true if there is no event waiting in the queue.
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+private:
+  struct Slot
+  {
+    Event event;
+    std::uint64_t postedAt = 0;
+  };
+
+  struct Lane
+  {
+    detail::MpscQueue<Slot> queue;
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::size_t> capacity{std::numeric_limits<std::size_t>::max()};
+    std::atomic<std::size_t> dropped{0};
+    std::size_t weight = 1;
+    std::size_t credit = 0;
+
+    bool pop(Slot& slot)
+    {
+      if (!queue.pop(slot))
+        return false;
+      size.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  };
+
+  //! Move the next event to be dispatched to \a slot and its lane index to \a index.
+  bool next(Slot& slot, std::size_t& index)
+  {
+    if (m_scheduling == Scheduling::Strict)
+    {
+      for (index = 0; index < PriorityCount; ++index)
+        if (m_lanes[index].pop(slot))
+          return true;
+      return false;
+    }
+
+    // Deficit round robin with unit cost: a lane with no credit left waits
+    // for the next round, which starts when no lane can dispatch anymore.
+    for (int round = 0; round < 2; ++round)
+    {
+      for (index = 0; index < PriorityCount; ++index)
+      {
+        auto& lane = m_lanes[index];
+        if (lane.credit > 0 && lane.pop(slot))
+        {
+          --lane.credit;
+          return true;
+        }
+      }
+      for (auto& lane : m_lanes)
+        lane.credit = lane.weight;
+    }
+    return false;
+  }
+
+  void dispatch(Slot& slot, std::size_t lane)
+  {
+    auto* recorder = m_recorder.load(std::memory_order_relaxed);
+    if (!recorder || !slot.postedAt)
+    {
+      slot.event();
+      return;
+    }
+
+    m_postedAt = slot.postedAt;
+    auto start = TscClock::now();
+    slot.event();
+    auto end = TscClock::now();
+    m_postedAt = 0;
+    recorder->recordEvent(static_cast<Priority>(lane), start - slot.postedAt, end - start);
+  }
+
+  void fillRemaining(DrainReport& report) const
+  {
+    for (std::size_t i = 0; i < PriorityCount; ++i)
+      report.remaining[i] = m_lanes[i].size.load(std::memory_order_relaxed);
+  }
+
+  std::array<Lane, PriorityCount> m_lanes;
+  Scheduling m_scheduling = Scheduling::Strict;
+  std::atomic<LatencyRecorder*> m_recorder{nullptr};
+  std::uint64_t m_postedAt = 0;
+};
+
+//! Sequence numbers of notifications of one source.
+/*!
+  Every notification gets the next number of the sequence when it is posted,
+  which costs one relaxed atomic increment. The consumer reports the numbers of
+  notifications it has dispatched, so that the sequence can tell how far the
+  consumer lags behind the producers and how many notifications were lost.
+
+  Notifications of different priority may be dispatched out of order. A number,
+  which is skipped, is counted as dropped until it arrives late.
+*/
+class Sequence
+{
+public:
+  //! Assign the next sequence number. May be called from any thread.
+  std::uint64_t next()
+  {
+    return m_produced.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  //! Report that notification \a number has been dispatched.
+  /*!
+    Only the consumer thread may call this method.
+  */
+  void consumed(std::uint64_t number)
+  {
+    auto last = m_consumed.load(std::memory_order_relaxed);
+    if (number > last)
+    {
+      if (number > last + 1)
+        m_dropped.fetch_add(number - last - 1, std::memory_order_relaxed);
+      m_consumed.store(number, std::memory_order_relaxed);
+    }
+    else
+    {
+      m_dropped.fetch_sub(1, std::memory_order_relaxed);
+      m_reordered.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  //! The last sequence number assigned to a notification.
+  std::uint64_t produced() const
+  {
+    return m_produced.load(std::memory_order_relaxed);
+  }
+
+  //! The highest sequence number dispatched so far.
+  std::uint64_t consumed() const
+  {
+    return m_consumed.load(std::memory_order_relaxed);
+  }
+
+  //! Number of notifications posted but not dispatched yet.
+  std::uint64_t lag() const
+  {
+    auto consumedNumber = consumed();
+    auto producedNumber = produced();
+    return producedNumber > consumedNumber ? producedNumber - consumedNumber : 0;
+  }
+
+  //! Number of notifications skipped by the consumer, i.e. lost on the way.
+  std::uint64_t dropped() const
+  {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+  //! Number of notifications, which were dispatched after a later one.
+  std::uint64_t reordered() const
+  {
+    return m_reordered.load(std::memory_order_relaxed);
+  }
+
+private:
+  // Not padded to separate cache lines, sources may exist in millions.
+  std::atomic<std::uint64_t> m_produced{0};
+  std::atomic<std::uint64_t> m_consumed{0};
+  std::atomic<std::uint64_t> m_dropped{0};
+  std::atomic<std::uint64_t> m_reordered{0};
+};
+
+namespace detail
+{
+//! Shared token, which tells deferred events whether their originator still exists.
+/*!
+  A copy of the token is a new token, so copying an owner does not make
+  events of the original owner deliverable to the copy.
+*/
+class LifeToken
+{
+public:
+  LifeToken() : m_token(std::make_shared<char>()) {}
+  LifeToken(const LifeToken&) : LifeToken() {}
+  LifeToken& operator=(const LifeToken&) { return *this; }
+
+  std::weak_ptr<void> watch() const { return m_token; }
+
+private:
+  std::shared_ptr<char> m_token;
+};
+}
+
+//! A container of listeners, which defers notifications to a Dispatcher.
+/*!
+  Listeners are held as raw pointers just like in RawContainer. A notification
+  copies its arguments and posts an event to the dispatcher. Listeners, which
+  are attached when the event is dispatched, are then notified. Events posted by
+  a container, which has been destroyed in the meantime, are silently dropped.
+
+  Notifications may be posted from any thread, but the listeners are attached,
+  detached and notified on the thread, which drains the dispatcher. The container
+  must be destroyed on that thread as well.
+
+  The lane of a notification is given either explicitly, or by the priority of
+  the notification method, or by the default priority of the container.
+
+  If the dispatcher records latencies, each listener call is recorded separately.
+  If a Sequence is set, every notification is numbered, so that lost and delayed
+  notifications can be detected.
+*/
+template <class T_Listener>
+class QueuedContainer : public RawContainer<T_Listener>
+{
+public:
+  ~QueuedContainer() override
+  {
+    if (auto* recorder = m_dispatcher ? m_dispatcher->installedLatencyRecorder() : nullptr)
+    {
+      for (auto* l : this->listeners())
+        recorder->forget(this, l);
+    }
+  }
+
+  //! Detach listener \a listener, see RawContainer::detach().
+  /*!
+    Latencies recorded for the listener are dropped by the latency recorder.
+  */
+  void detach(T_Listener* listener)
+  {
+    RawContainer<T_Listener>::detach(listener);
+    if (auto* recorder = m_dispatcher ? m_dispatcher->installedLatencyRecorder() : nullptr)
+      recorder->forget(this, listener);
+  }
+
+  //! Set the dispatcher, which receives notifications of this container.
+  void setDispatcher(Dispatcher* dispatcher)
+  {
+    m_dispatcher = dispatcher;
+  }
+
+  //! Memory occupied by this container.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = RawContainer<T_Listener>::memoryUsage();
+    auto priorities = detail::vectorUsage(m_methodPriorities, 0);
+    usage.bytesUsed += sizeof(*this) - sizeof(RawContainer<T_Listener>) + priorities.bytesUsed;
+    usage.bytesReserved += sizeof(*this) - sizeof(RawContainer<T_Listener>) + priorities.bytesReserved;
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    RawContainer<T_Listener>::shrink();
+    m_methodPriorities.shrink_to_fit();
+  }
+
+  //! Set the sequence, which numbers notifications of this container.
+  void setSequence(Sequence* sequence)
+  {
+    m_sequence = sequence;
+  }
+
+  //! Set the lane, which is used by notifications without an explicit priority.
+  void setPriority(Priority priority)
+  {
+    m_priority = priority;
+  }
+
+  //! Set the lane, which is used by notifications of method \a fn.
+  template <typename... Fn_Args>
+  void setPriority(void (T_Listener::*fn)(Fn_Args...), Priority priority)
+  {
+    MethodId method(fn);
+    for (auto& entry : m_methodPriorities)
+      if (entry.first == method)
+      {
+        entry.second = priority;
+        return;
+      }
+    m_methodPriorities.emplace_back(method, priority);
+  }
+
+protected:
+
+  //! Post a notification to the dispatcher using the lane of method \a fn.
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    notify(priority(fn), fn, std::forward<Fn_Args>(args)...);
+  }
+
+  //! Post a notification to the dispatcher using the lane given by \a priority.
+  template <typename... Fn_Args>
+  void notify(Priority priority, void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    assert(m_dispatcher);
+    auto number = m_sequence ? m_sequence->next() : 0;
+    m_dispatcher->post(priority,
+      [this, alive = m_life.watch(), fn, number,
+       params = std::make_tuple(std::decay_t<Fn_Args>(std::forward<Fn_Args>(args))...)]() mutable
+      {
+        if (alive.expired())
+          return;
+        if (number)
+          m_sequence->consumed(number);
+        std::apply([this, fn](auto&... values)
+          {
+            if (auto* recorder = m_dispatcher->latencyRecorder())
+              recordedNotify(*recorder, fn, static_cast<Fn_Args&&>(values)...);
+            else
+              this->RawContainer<T_Listener>::notify(fn, static_cast<Fn_Args&&>(values)...);
+          }, params);
+      });
+  }
+
+  //! Not supported, since the arguments of the calls cannot be queued, see Source::notifyAll().
+  /*!
+    Hides RawContainer::notifyAll(), so that notifyAll() of the source posts the
+    notifications one after another.
+  */
+  template <class... T_Calls>
+  void notifyAll(const T_Calls&... calls) = delete;
+
+private:
+  //! Notify the listeners and record the latency of each call.
+  template <typename... Fn_Args>
+  void recordedNotify(LatencyRecorder& recorder, void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    auto postedAt = m_dispatcher->postedAt();
+    auto* monitor = detail::CallMonitor::sample();
+    for (auto& l : this->listeners())
+    {
+      auto start = TscClock::now();
+      (l->*fn)(std::forward<Fn_Args>(args)...);
+      auto end = TscClock::now();
+      recorder.recordCall(this, l, typeid(T_Listener), start - postedAt, end - start);
+      if (monitor)
+        monitor->report(l, MethodId(fn), std::chrono::nanoseconds(
+          static_cast<std::chrono::nanoseconds::rep>(TscClock::toNanoseconds(end - start))));
+    }
+  }
+
+  template <typename... Fn_Args>
+  Priority priority(void (T_Listener::*fn)(Fn_Args...)) const
+  {
+    if (!m_methodPriorities.empty())
+    {
+      MethodId method(fn);
+      for (const auto& entry : m_methodPriorities)
+        if (entry.first == method)
+          return entry.second;
+    }
+    return m_priority;
+  }
+
+  Dispatcher* m_dispatcher = nullptr;
+  Sequence* m_sequence = nullptr;
+  Priority m_priority = Priority::Normal;
+  std::vector<std::pair<MethodId, Priority>> m_methodPriorities;
+  detail::LifeToken m_life;
+};
+
+//! Base class for sources, which defer their notifications to a Dispatcher.
+/*!
+  All listener containers of the source post to the same dispatcher, which is
+  given in the constructor. Notifications of all containers are numbered by one
+  Sequence, which tells how far the dispatcher lags behind the source and how many
+  notifications of the source were dropped.
+*/
+template <class... T_Listeners>
+class QueuedSource
+  : public Source<QueuedContainer, T_Listeners...>
+{
+public:
+  explicit QueuedSource(Dispatcher& dispatcher)
+  {
+    (QueuedContainer<T_Listeners>::setDispatcher(&dispatcher), ...);
+    (QueuedContainer<T_Listeners>::setSequence(&m_sequence), ...);
+  }
+
+  QueuedSource(const QueuedSource& other)
+    : Source<QueuedContainer, T_Listeners...>(other)
+  {
+    (QueuedContainer<T_Listeners>::setSequence(&m_sequence), ...);
+  }
+
+  QueuedSource& operator=(const QueuedSource& other)
+  {
+    Source<QueuedContainer, T_Listeners...>::operator=(other);
+    (QueuedContainer<T_Listeners>::setSequence(&m_sequence), ...);
+    return *this;
+  }
+
+  //! Sequence numbers of notifications of this source.
+  const Sequence& sequence() const
+  {
+    return m_sequence;
+  }
+
+  //! Set the default lane of notifications of listener \a T.
+  template <class T>
+  void setPriority(Priority priority)
+  {
+    QueuedContainer<T>::setPriority(priority);
+  }
+
+  //! Set the lane of notifications of method \a fn.
+  template <class T, typename... Fn_Args>
+  void setPriority(void (T::*fn)(Fn_Args...), Priority priority)
+  {
+    QueuedContainer<T>::setPriority(fn, priority);
+  }
+
+protected:
+  using Source<QueuedContainer, T_Listeners...>::notify;
+
+  //! Post a notification to the lane given by \a priority.
+  template <typename T, typename... Fn_Args>
+  void notify(
+    Priority priority,
+    void (T::*fn)(Fn_Args...),
+    Fn_Args&&... args)
+    {
+      QueuedContainer<T>::notify(priority, fn, std::forward<Fn_Args>(args)...);
+    }
+
+private:
+  Sequence m_sequence;
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_DISPATCHER_H
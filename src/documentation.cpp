@@ -56,4 +56,26 @@
   Clearly, the only abstract listener supported by the concrete listener and the source is \a ListenerB.
   Still, the user may attach the concrete listener to the source without a compiler error and only the correct
   abstract interfaces are taken into account and attached to the source as one would expect.
+
+  \section queued Queued notifications
+
+  Sometimes listeners should not be called at the moment the event occurs, e.g. a render loop
+  processes events only within a time budget of each frame. Observer::QueuedSource posts
+  notifications to an Observer::Dispatcher instead of calling the listeners directly.
+  Observer::Dispatcher::drain() then dispatches the events until the deadline is reached and
+  reports how many events were left behind for the next frame. Urgent notifications may be
+  posted to a lane of higher priority, either explicitly or by assigning a priority to the
+  notification method. Lanes are drained by strict priority or, to avoid starvation of the
+  less urgent lanes, by weighted fair scheduling. Notifications may be posted from any thread.
+
+  \snippet snippets.cpp QueuedExample
+
+  \section benchmark Benchmarks
+
+  The benchmark.pro project builds a benchmark application, which measures the containers and
+  dispatchers of this library. Run it with a list of scenarios to be measured, or without
+  arguments to run all of them. Option --scale multiplies the size of all scenarios.
+  Script src/benchmark/compile-time.sh measures the compile time and object size of
+  sources with many listener interfaces and script src/benchmark/code-size.sh compares
+  the code size of templated and type-erased notification loops.
 */
@@ -0,0 +1,284 @@
+#ifndef OBSERVER_EPOCH_H
+#define OBSERVER_EPOCH_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "reclaim.h"
+
+namespace Observer
+{
+
+//! Epoch-based reclamation of objects, which may still be read by other threads.
+/*!
+  Concurrent containers replace their listener arrays while other threads may
+  still be notifying through the old ones. An old array is handed over to
+  retire() and it is deleted once every thread, which could have seen it, has
+  left its critical section.
+
+  Readers enter a critical section by constructing a Guard. A guard costs
+  a relaxed load of the global epoch and a relaxed store of the thread's
+  announcement, leaving costs a release store. On Linux with membarrier the
+  reader needs no fence, the reclaiming thread issues a process-wide barrier
+  instead, otherwise the reader issues a sequentially consistent fence.
+  Guards nest, nested guards only count their depth.
+
+  Retired objects are kept in a list of the retiring thread and the list is
+  collected once it reaches the batch size, so the cost of scanning the
+  announcements of all threads is shared by many retired objects.
+
+  Applications running in frames may keep one guard for the whole frame and
+  call quiescent() between frames instead of entering a section per notification.
+
+  A domain must outlive all threads, which have entered it, except the one
+  destroying it. The global() domain is never destroyed.
+*/
+class EpochDomain
+{
+  struct Record;
+
+public:
+  //! Number of retired objects of a thread, which triggers collect().
+  static constexpr std::size_t DefaultBatchSize = 64;
+
+  //! A critical section of the calling thread.
+  /*!
+    Objects retired after the guard was constructed are not deleted before
+    the guard is destroyed.
+  */
+  class Guard
+  {
+  public:
+    explicit Guard(EpochDomain& domain = EpochDomain::global())
+      : m_domain(domain)
+      , m_record(domain.enter())
+    {}
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    ~Guard()
+    {
+      m_domain.leave(m_record);
+    }
+
+    //! Load a pointer to an object, which is retired to the domain when replaced.
+    template <class T>
+    T* protect(const std::atomic<T*>& source) const
+    {
+      return source.load(std::memory_order_acquire);
+    }
+
+  private:
+    EpochDomain& m_domain;
+    Record& m_record;
+  };
+
+  explicit EpochDomain(std::size_t batchSize = DefaultBatchSize)
+    : m_batchSize(batchSize ? batchSize : 1)
+  {}
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  //! Deletes all retired objects.
+  /*!
+    Other threads, which have entered the domain, must have finished.
+  */
+  ~EpochDomain()
+  {
+    m_records.forEach([](Record& record)
+    {
+      assert(!(record.state.load(std::memory_order_relaxed) & Active));
+      for (auto& retired : record.retired)
+        retired.deleter(retired.pointer);
+    });
+  }
+
+  //! The domain shared by all containers of the library.
+  static EpochDomain& global()
+  {
+    static EpochDomain* domain = new EpochDomain;
+    return *domain;
+  }
+
+  //! Delete \a pointer by \a deleter once no thread can read it anymore.
+  /*!
+    The object must already be unreachable for threads entering a guard from
+    now on. \a bytes is accounted in pendingBytes().
+  */
+  void retire(void* pointer, void (*deleter)(void*), std::size_t bytes = 0)
+  {
+    assert(pointer && deleter);
+    Record& record = m_records.local();
+    std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+    record.retired.push_back({ pointer, deleter, epoch, bytes });
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_pendingBytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (record.retired.size() >= m_batchSize)
+      collect(record);
+  }
+
+  //! Delete \a object by delete once no thread can read it anymore.
+  template <class T>
+  void retire(T* object, std::size_t bytes = sizeof(T))
+  {
+    retire(static_cast<void*>(object), [](void* pointer) { delete static_cast<T*>(pointer); }, bytes);
+  }
+
+  //! Announce that the calling thread holds no pointer read under its guards so far.
+  /*!
+    A thread, which keeps a guard for a whole frame, calls this between frames,
+    so that the epoch may advance. Objects retired by the thread are collected.
+  */
+  void quiescent()
+  {
+    Record& record = m_records.local();
+    if (record.depth)
+      announce(record);
+    if (!record.retired.empty())
+      collect(record);
+  }
+
+  //! Try to advance the epoch and delete objects retired by the calling thread, which are safe.
+  void collect()
+  {
+    collect(m_records.local());
+  }
+
+  //! Number of retired objects, which have not been deleted yet.
+  std::size_t pending() const
+  {
+    return m_pending.load(std::memory_order_relaxed);
+  }
+
+  //! Sum of sizes of retired objects, which have not been deleted yet.
+  std::size_t pendingBytes() const
+  {
+    return m_pendingBytes.load(std::memory_order_relaxed);
+  }
+
+  //! True if readers need no fence, because the reclaimer uses membarrier.
+  bool asymmetric() const
+  {
+    return m_fence.enabled();
+  }
+
+private:
+  // An announcement is the epoch shifted by one with the lowest bit set,
+  // while the thread is inside a guard, or zero otherwise.
+  static constexpr std::uint64_t Active = 1;
+
+  struct Retired
+  {
+    void* pointer;
+    void (*deleter)(void*);
+    std::uint64_t epoch;
+    std::size_t bytes;
+  };
+
+  //! State of one thread.
+  struct Record : detail::ThreadRecord
+  {
+    std::atomic<std::uint64_t> state{0};
+    // Touched only by the thread, which uses the record.
+    unsigned depth = 0;
+    std::vector<Retired> retired;
+  };
+
+  Record& enter()
+  {
+    Record& record = m_records.local();
+    if (record.depth++ == 0)
+      announce(record);
+    return record;
+  }
+
+  void leave(Record& record)
+  {
+    assert(record.depth);
+    if (--record.depth == 0)
+      record.state.store(0, std::memory_order_release);
+  }
+
+  void announce(Record& record)
+  {
+    record.state.store((m_epoch.load(std::memory_order_relaxed) << 1) | Active, std::memory_order_relaxed);
+    // The announcement must be visible before the reader loads any protected pointer.
+    m_fence.light();
+  }
+
+  //! Advance the epoch if all threads inside a guard have seen the current one.
+  std::uint64_t tryAdvance()
+  {
+    m_fence.heavy();
+    std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+    const std::uint64_t current = (epoch << 1) | Active;
+    bool seen = true;
+    m_records.forEach([&seen, current](const Record& record)
+    {
+      std::uint64_t state = record.state.load(std::memory_order_acquire);
+      if ((state & Active) && state != current)
+        seen = false;
+    });
+    if (seen && m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst))
+      return epoch + 1;
+    return epoch;
+  }
+
+  //! An object retired in epoch e may be read only by threads, which announced e or less.
+  //! Such threads have left their guards, once the epoch reached e + 2.
+  void reclaim(std::vector<Retired>& retired, std::uint64_t epoch)
+  {
+    std::size_t count = 0, bytes = 0;
+    auto kept = retired.begin();
+    for (auto& entry : retired)
+    {
+      if (entry.epoch + 2 <= epoch)
+      {
+        entry.deleter(entry.pointer);
+        ++count;
+        bytes += entry.bytes;
+      }
+      else
+      {
+        *kept++ = entry;
+      }
+    }
+    retired.erase(kept, retired.end());
+    m_pending.fetch_sub(count, std::memory_order_relaxed);
+    m_pendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  void collect(Record& record)
+  {
+    std::uint64_t epoch = tryAdvance();
+    reclaim(record.retired, epoch);
+
+    // Objects left behind by finished threads.
+    m_records.forEach([this, epoch](Record& other)
+    {
+      // The list may be read only once the record is acquired, a live thread may be changing it.
+      if (other.tryAcquire())
+      {
+        if (!other.retired.empty())
+          reclaim(other.retired, epoch);
+        other.release();
+      }
+    });
+  }
+
+  alignas(64) std::atomic<std::uint64_t> m_epoch{1};
+  std::atomic<std::size_t> m_pending{0};
+  std::atomic<std::size_t> m_pendingBytes{0};
+  const std::size_t m_batchSize;
+  detail::AsymmetricFence m_fence;
+  detail::ThreadRecords<Record> m_records;
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_EPOCH_H
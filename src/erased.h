@@ -0,0 +1,151 @@
+#ifndef OBSERVER_ERASED_H
+#define OBSERVER_ERASED_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "observer.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define OBSERVER_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define OBSERVER_NOINLINE __declspec(noinline)
+#else
+#define OBSERVER_NOINLINE
+#endif
+
+namespace Observer
+{
+
+namespace detail
+{
+//! Calls the notification described by \a call on \a listener.
+using ErasedInvoker = void (*)(void* listener, const void* call);
+
+//! Identifies the method of the notification described by \a call.
+using ErasedIdentifier = MethodId (*)(const void* call);
+
+//! The notification loop shared by all notifications of all ErasedContainer types.
+/*!
+  It is deliberately not inlined, so that there is one copy of the loop in the
+  whole program and its code stays in the instruction cache.
+*/
+OBSERVER_NOINLINE inline void notifyErased(void* const* listeners, std::size_t count,
+  ErasedInvoker invoke, ErasedIdentifier identify, const void* call)
+{
+  if (auto* monitor = CallMonitor::sample())
+  {
+    auto method = identify(call);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      auto start = std::chrono::steady_clock::now();
+      invoke(listeners[i], call);
+      monitor->report(listeners[i], method, std::chrono::steady_clock::now() - start);
+    }
+    return;
+  }
+
+  for (std::size_t i = 0; i < count; ++i)
+    invoke(listeners[i], call);
+}
+}
+
+//! A container of listeners, whose notifications share one non-template loop.
+/*!
+  Every notification method of RawContainer instantiates its own loop, which
+  adds up to a lot of code in programs with many notification methods. This
+  container instantiates only a small trampoline per method, which calls the
+  method on one listener, and passes it to detail::notifyErased(). Every call
+  is indirect, so the container pays off when there are many notification
+  methods and few listeners each, see the "erased" benchmark and script
+  src/benchmark/code-size.sh.
+
+  Behaves like RawContainer otherwise, so listeners are held as raw pointers.
+*/
+template <class T_Listener>
+class ErasedContainer
+{
+public:
+  virtual ~ErasedContainer() {}
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    assert(listener);
+    m_listeners.push_back(listener);
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    void* erased = listener;
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), erased), m_listeners.end());
+  }
+
+  //! Memory occupied by this container.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    usage.liveEntries = m_listeners.size();
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    m_listeners.shrink_to_fit();
+  }
+
+  //! Sort listeners by their address, see RawContainer::compact().
+  void compact()
+  {
+    std::sort(m_listeners.begin(), m_listeners.end(), std::less<void*>());
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    Call<T_Listener, Fn_Args...> call(fn, std::forward<Fn_Args>(args)...);
+    detail::notifyErased(m_listeners.data(), m_listeners.size(), &invoke<Fn_Args...>, &identify<Fn_Args...>, &call);
+  }
+
+private:
+  //! The trampoline of one notification method.
+  template <typename... Fn_Args>
+  static void invoke(void* listener, const void* call)
+  {
+    (*static_cast<const Call<T_Listener, Fn_Args...>*>(call))(static_cast<T_Listener*>(listener));
+  }
+
+  //! The method of a notification, which is needed only when the call is sampled.
+  template <typename... Fn_Args>
+  static MethodId identify(const void* call)
+  {
+    return MethodId(static_cast<const Call<T_Listener, Fn_Args...>*>(call)->method());
+  }
+
+  // Listeners are stored as void* to be passed to the shared loop as they are.
+  std::vector<void*> m_listeners;
+};
+
+//! Shortcut for a source, whose notifications share one non-template loop
+template <class... T_Listeners>
+using ErasedSource = Source<ErasedContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_ERASED_H
@@ -0,0 +1,703 @@
+#ifndef OBSERVER_EXECUTOR_H
+#define OBSERVER_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "completion.h"
+
+namespace Observer
+{
+
+namespace detail
+{
+//! A unit of work of an Executor, which is a chunk of listeners of one broadcast.
+struct Task
+{
+  void (*run)(Task& task) = nullptr;
+  // Link in an inbox of a worker.
+  Task* next = nullptr;
+};
+
+//! Unbounded work-stealing deque by Chase and Lev, as formulated for C11 atomics by Lê et al.
+/*!
+  The owner thread pushes and takes at the bottom, other threads steal at the
+  top. Arrays outgrown by the deque are kept until it is destroyed, since
+  thieves may still read them.
+*/
+class TaskDeque
+{
+public:
+  explicit TaskDeque(std::size_t capacity = 256)
+  {
+    m_arrays.push_back(std::make_unique<Array>(capacity));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+  }
+
+  TaskDeque(const TaskDeque&) = delete;
+  TaskDeque& operator=(const TaskDeque&) = delete;
+
+  //! Push \a task at the bottom. Only the owner may call this.
+  void push(Task* task)
+  {
+    std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    Array* array = m_array.load(std::memory_order_relaxed);
+    if (bottom - top > std::int64_t(array->capacity) - 1)
+      array = grow(array, top, bottom);
+    array->put(bottom, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  //! Take the task pushed last, or null if there is none. Only the owner may call this.
+  Task* take()
+  {
+    std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    Array* array = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom)
+    {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    Task* task = array->get(bottom);
+    if (top == bottom)
+    {
+      // The last task, race with thieves for it.
+      if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        task = nullptr;
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  //! Take the task pushed first, or null if there is none or another thread won it.
+  Task* steal()
+  {
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+      return nullptr;
+
+    Task* task = m_array.load(std::memory_order_acquire)->get(top);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return nullptr;
+    return task;
+  }
+
+  //! True if the deque seems to be empty, which may be outdated immediately.
+  bool empty() const
+  {
+    return m_top.load(std::memory_order_relaxed) >= m_bottom.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Array
+  {
+    explicit Array(std::size_t size)
+      : capacity(size)
+      , mask(size - 1)
+      , tasks(new std::atomic<Task*>[size])
+    {
+      assert((size & mask) == 0 && "Capacity must be a power of two");
+    }
+
+    Task* get(std::int64_t index) const
+    {
+      return tasks[std::size_t(index) & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t index, Task* task)
+    {
+      tasks[std::size_t(index) & mask].store(task, std::memory_order_relaxed);
+    }
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<Task*>[]> tasks;
+  };
+
+  Array* grow(Array* array, std::int64_t top, std::int64_t bottom)
+  {
+    m_arrays.push_back(std::make_unique<Array>(2 * array->capacity));
+    Array* grown = m_arrays.back().get();
+    for (std::int64_t i = top; i < bottom; ++i)
+      grown->put(i, array->get(i));
+    m_array.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  alignas(64) std::atomic<std::int64_t> m_top{0};
+  alignas(64) std::atomic<std::int64_t> m_bottom{0};
+  std::atomic<Array*> m_array{nullptr};
+  std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
+//! Lock-free stack of tasks, to which any thread pushes and whose owner takes all tasks at once.
+class TaskInbox
+{
+public:
+  void push(Task* first, Task* last)
+  {
+    Task* head = m_head.load(std::memory_order_relaxed);
+    do
+    {
+      last->next = head;
+    } while (!m_head.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  Task* takeAll()
+  {
+    if (!m_head.load(std::memory_order_relaxed))
+      return nullptr;
+    return m_head.exchange(nullptr, std::memory_order_acquire);
+  }
+
+  bool empty() const
+  {
+    return !m_head.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<Task*> m_head{nullptr};
+};
+}
+
+//! Workers of an Executor sharing a NUMA node, see NumaTopology::workerGroups().
+struct WorkerGroup
+{
+  //! Number of workers, one per CPU if zero, or all hardware threads if there are no CPUs.
+  std::size_t workers = 0;
+  //! CPUs the workers are pinned to, the workers are not pinned if empty.
+  std::vector<int> cpus;
+  //! Home node of the listeners, which are delivered by this group.
+  unsigned node = 0;
+};
+
+//! Thread pool for asynchronous notifications, see Source::notifyAsync().
+/*!
+  A broadcast to many listeners is split into tasks of up to grain() listeners.
+  A thread, which is not a worker, spreads the tasks over inboxes of all
+  workers, so there is no central queue. Workers move tasks from their inbox
+  to their own Chase-Lev deque, take tasks from its bottom and, once it is
+  empty, steal from the top of the deques of other workers. A worker, which
+  broadcasts from inside a listener, pushes the tasks to its own deque. A
+  listener may wait for such a broadcast, its worker runs tasks until the
+  broadcast is done. Idle workers sleep and are woken up by the next broadcast.
+
+  Workers may be split into groups, typically one per NUMA node, whose
+  workers are pinned to the CPUs of the node. A broadcast given home nodes
+  of its listeners hands every listener to the group of its home node only
+  and workers steal from workers of their own group only, so listeners are
+  called next to their memory. A broadcast without home nodes is spread
+  over all groups, unless it is made by a worker, whose deque keeps it in
+  the group of the worker.
+
+  A listener must not throw, an exception escaping a worker terminates the
+  program. The destructor runs all tasks, which have been submitted, also
+  those submitted by listeners meanwhile, and joins the workers.
+*/
+class Executor
+{
+public:
+  //! Default number of listeners of a task.
+  static constexpr std::size_t DefaultGrain = 16;
+
+  //! Start \a workers threads, all hardware threads if zero.
+  explicit Executor(std::size_t workers = 0, std::size_t grain = DefaultGrain)
+    : Executor(std::vector<WorkerGroup>{ WorkerGroup{ workers, {}, 0 } }, grain)
+  {}
+
+  //! Start a group of worker threads for every item of \a groups.
+  explicit Executor(const std::vector<WorkerGroup>& groups, std::size_t grain = DefaultGrain)
+    : m_grain(grain ? grain : 1)
+  {
+    assert(!groups.empty());
+    for (const auto& g : groups)
+    {
+      std::size_t workers = g.workers;
+      if (!workers)
+        workers = g.cpus.empty() ? std::max<std::size_t>(std::thread::hardware_concurrency(), 1) : g.cpus.size();
+      m_groups.push_back(std::make_unique<Group>(m_workers.size(), workers, g));
+      for (std::size_t i = 0; i < workers; ++i)
+        m_workers.push_back(std::make_unique<Worker>(m_workers.size(), m_groups.size() - 1));
+    }
+    for (std::size_t i = 0; i < m_workers.size(); ++i)
+      m_workers[i]->thread = std::thread([this, i] { run(i); });
+  }
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  ~Executor()
+  {
+    m_stopping.store(true, std::memory_order_seq_cst);
+    {
+      auto locks = lockAll();
+      if (idle(0))
+        stop();
+    }
+    for (auto& worker : m_workers)
+      worker->thread.join();
+  }
+
+  //! Number of worker threads.
+  std::size_t workerCount() const
+  {
+    return m_workers.size();
+  }
+
+  //! Number of worker groups.
+  std::size_t groupCount() const
+  {
+    return m_groups.size();
+  }
+
+  //! Index of the group of the calling worker, or groupCount() if the caller is not a worker of this executor.
+  std::size_t currentGroup() const
+  {
+    return t_executor == this ? m_workers[t_worker]->group : m_groups.size();
+  }
+
+  //! Maximal number of listeners of a task.
+  std::size_t grain() const
+  {
+    return m_grain;
+  }
+
+  //! Call \a fn with \a args on all \a listeners on the worker threads.
+  /*!
+    The arguments are copied and shared by all listeners, so parameters taken
+    by non-const reference are shared by listeners running in parallel and
+    parameters taken by rvalue reference are not supported. The listeners
+    must exist until the notification is done.
+  */
+  template <class T_Listener, typename... Fn_Args>
+  Completion broadcast(std::vector<T_Listener*> listeners, void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    static_assert(!std::disjunction<std::is_rvalue_reference<Fn_Args>...>::value,
+      "Arguments passed by rvalue reference cannot be shared by listeners running in parallel");
+    const std::size_t ranges[] = { 0, listeners.size() };
+    return start(std::move(listeners), ranges, AnyGroup, fn, std::forward<Fn_Args>(args)...);
+  }
+
+  //! Call \a fn with \a args on all \a listeners on the workers of the home node of each listener.
+  /*!
+    Item \a homes[i] is the home node of \a listeners[i], listeners of a node
+    without a worker group are dealt to the groups in turn. Otherwise this is
+    the same as the overload without home nodes.
+  */
+  template <class T_Listener, typename... Fn_Args>
+  Completion broadcast(std::vector<T_Listener*> listeners, const std::vector<unsigned>& homes,
+    void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    static_assert(!std::disjunction<std::is_rvalue_reference<Fn_Args>...>::value,
+      "Arguments passed by rvalue reference cannot be shared by listeners running in parallel");
+    assert(homes.size() == listeners.size());
+
+    // Order the listeners by group, so that a task holds listeners of one group only.
+    const std::size_t groupCount = m_groups.size();
+    std::vector<std::size_t> ranges(groupCount + 1, 0);
+    std::vector<std::size_t> groups(listeners.size());
+    std::size_t homeless = 0;
+    for (std::size_t i = 0; i < listeners.size(); ++i)
+    {
+      groups[i] = groupOf(homes[i]);
+      if (groups[i] == groupCount)
+        groups[i] = homeless++ % groupCount;
+      ++ranges[groups[i] + 1];
+    }
+    for (std::size_t g = 0; g < groupCount; ++g)
+      ranges[g + 1] += ranges[g];
+
+    std::vector<T_Listener*> ordered(listeners.size());
+    std::vector<std::size_t> next(ranges.begin(), ranges.end() - 1);
+    for (std::size_t i = 0; i < listeners.size(); ++i)
+      ordered[next[groups[i]]++] = listeners[i];
+    return start(std::move(ordered), ranges.data(), groupCount, fn, std::forward<Fn_Args>(args)...);
+  }
+
+private:
+  //! An asynchronous notification, which owns its copies of the listeners and the arguments.
+  template <class T_Listener, typename... Fn_Args>
+  struct Broadcast : detail::AsyncState
+  {
+    struct Chunk : detail::Task
+    {
+      Broadcast* broadcast = nullptr;
+      std::size_t begin = 0;
+      std::size_t end = 0;
+    };
+
+    template <typename... T_Args>
+    Broadcast(std::vector<T_Listener*> l, void (T_Listener::*f)(Fn_Args...), T_Args&&... a)
+      : fn(f)
+      , args(std::forward<T_Args>(a)...)
+      , listeners(std::move(l))
+    {
+      destroy = [](detail::AsyncState* state) { delete static_cast<Broadcast*>(state); };
+    }
+
+    static void run(detail::Task& task)
+    {
+      auto& chunk = static_cast<Chunk&>(task);
+      Broadcast& broadcast = *chunk.broadcast;
+      for (std::size_t i = chunk.begin; i < chunk.end; ++i)
+      {
+        T_Listener* listener = broadcast.listeners[i];
+        std::apply([listener, &broadcast](auto&... values) { (listener->*broadcast.fn)(values...); }, broadcast.args);
+      }
+      broadcast.finishTask();
+    }
+
+    void (T_Listener::*fn)(Fn_Args...);
+    std::tuple<std::decay_t<Fn_Args>...> args;
+    std::vector<T_Listener*> listeners;
+    std::unique_ptr<Chunk[]> chunks;
+  };
+
+  struct Worker
+  {
+    Worker(std::size_t index, std::size_t g)
+      : group(g)
+      , random(static_cast<unsigned>(index + 1))
+    {}
+
+    detail::TaskDeque deque;
+    detail::TaskInbox inbox;
+    const std::size_t group;
+    std::thread thread;
+    // Chooses victims of stealing, used only by the worker.
+    std::minstd_rand random;
+  };
+
+  //! Workers of a WorkerGroup, which are m_workers[first, first + count), and their sleeping place.
+  struct Group
+  {
+    Group(std::size_t f, std::size_t c, const WorkerGroup& g)
+      : first(f)
+      , count(c)
+      , node(g.node)
+      , cpus(g.cpus)
+    {}
+
+    const std::size_t first;
+    const std::size_t count;
+    const unsigned node;
+    const std::vector<int> cpus;
+    std::atomic<std::size_t> nextInbox{0};
+    alignas(64) std::atomic<std::uint64_t> submissions{0};
+    std::atomic<std::size_t> sleeping{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+  };
+
+  //! Tasks may be run by workers of any group.
+  static constexpr std::size_t AnyGroup = std::size_t(-1);
+
+  //! Index of the group of home node \a node, or the number of groups if the node has no group.
+  std::size_t groupOf(unsigned node) const
+  {
+    for (std::size_t g = 0; g < m_groups.size(); ++g)
+    {
+      if (m_groups[g]->node == node)
+        return g;
+    }
+    return m_groups.size();
+  }
+
+  //! Split \a listeners into tasks and submit them.
+  /*!
+    With \a groups equal to AnyGroup all tasks may run anywhere, otherwise
+    listeners [ranges[g], ranges[g + 1]) are delivered by group g.
+  */
+  template <class T_Listener, typename... Fn_Args>
+  Completion start(std::vector<T_Listener*> listeners, const std::size_t* ranges, std::size_t groups,
+    void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    if (listeners.empty())
+      return Completion();
+
+    using B = Broadcast<T_Listener, Fn_Args...>;
+    auto* broadcast = new B(std::move(listeners), fn, std::forward<Fn_Args>(args)...);
+    Completion completion(broadcast);
+
+    const std::size_t rangeCount = groups == AnyGroup ? 1 : groups;
+    std::size_t taskCount = 0;
+    for (std::size_t r = 0; r < rangeCount; ++r)
+      taskCount += (ranges[r + 1] - ranges[r] + m_grain - 1) / m_grain;
+    broadcast->chunks.reset(new typename B::Chunk[taskCount]);
+    broadcast->remaining.store(taskCount, std::memory_order_relaxed);
+
+    std::size_t task = 0;
+    for (std::size_t r = 0; r < rangeCount; ++r)
+    {
+      const std::size_t firstTask = task;
+      for (std::size_t begin = ranges[r]; begin < ranges[r + 1]; begin += m_grain)
+      {
+        auto& chunk = broadcast->chunks[task++];
+        chunk.run = &B::run;
+        chunk.broadcast = broadcast;
+        chunk.begin = begin;
+        chunk.end = std::min(ranges[r + 1], begin + m_grain);
+      }
+      if (task != firstTask)
+        submit(&broadcast->chunks[firstTask], task - firstTask, groups == AnyGroup ? AnyGroup : r);
+    }
+    return completion;
+  }
+
+  //! Hand \a count tasks stored in \a tasks over to the workers of \a group.
+  /*!
+    A worker pushes tasks of its own group or of AnyGroup to its deque, so the
+    latter stay in its group, as workers steal within their group only.
+  */
+  template <class T_Task>
+  void submit(T_Task* tasks, std::size_t count, std::size_t group)
+  {
+    if (t_executor == this && (group == AnyGroup || m_workers[t_worker]->group == group))
+    {
+      auto& deque = m_workers[t_worker]->deque;
+      for (std::size_t i = 0; i < count; ++i)
+        deque.push(&tasks[i]);
+      wake(m_workers[t_worker]->group);
+      return;
+    }
+
+    // Deal consecutive runs of tasks to the inboxes, starting where the last broadcast stopped.
+    const std::size_t first = group == AnyGroup ? 0 : m_groups[group]->first;
+    const std::size_t workers = group == AnyGroup ? m_workers.size() : m_groups[group]->count;
+    auto& nextInbox = group == AnyGroup ? m_nextInbox : m_groups[group]->nextInbox;
+    const std::size_t run = (count + workers - 1) / workers;
+    std::size_t start = nextInbox.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t begin = 0, w = 0; begin < count; begin += run, ++w)
+    {
+      std::size_t last = std::min(count, begin + run) - 1;
+      for (std::size_t i = begin; i < last; ++i)
+        tasks[i].next = &tasks[i + 1];
+      m_workers[first + (start + w) % workers]->inbox.push(&tasks[begin], &tasks[last]);
+    }
+
+    if (group != AnyGroup)
+      wake(group);
+    else
+    {
+      for (std::size_t g = 0; g < m_groups.size(); ++g)
+        wake(g);
+    }
+  }
+
+  //! Wake up sleeping workers of group \a index.
+  void wake(std::size_t index)
+  {
+    Group& group = *m_groups[index];
+    group.submissions.fetch_add(1, std::memory_order_seq_cst);
+    if (group.sleeping.load(std::memory_order_seq_cst))
+    {
+      std::lock_guard<std::mutex> lock(group.sleepMutex);
+      group.wake.notify_all();
+    }
+  }
+
+  //! Lock the sleeping places of all groups, in the order of the groups.
+  std::vector<std::unique_lock<std::mutex>> lockAll()
+  {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto& group : m_groups)
+      locks.emplace_back(group->sleepMutex);
+    return locks;
+  }
+
+  //! True if all workers but \a awake ones sleep and no task is left. Requires lockAll().
+  /*!
+    Sleeping workers have published their tasks by unlocking their group, so
+    the deques and inboxes are read reliably.
+  */
+  bool idle(std::size_t awake) const
+  {
+    for (const auto& group : m_groups)
+      awake += group->sleeping.load(std::memory_order_relaxed);
+    if (awake != m_workers.size())
+      return false;
+    for (const auto& worker : m_workers)
+    {
+      if (!worker->deque.empty() || !worker->inbox.empty())
+        return false;
+    }
+    return true;
+  }
+
+  //! Let all workers return. Requires lockAll().
+  void stop()
+  {
+    m_stopped.store(true, std::memory_order_relaxed);
+    for (auto& group : m_groups)
+      group->wake.notify_all();
+  }
+
+  //! Find a task for worker \a index, first in its own deque, then in its inbox, then in deques of its group.
+  detail::Task* find(std::size_t index)
+  {
+    Worker& worker = *m_workers[index];
+    if (detail::Task* task = worker.deque.take())
+      return task;
+
+    if (detail::Task* task = worker.inbox.takeAll())
+    {
+      // Keep the first task and make the others available to thieves.
+      for (detail::Task* other = task->next; other; )
+      {
+        detail::Task* next = other->next;
+        worker.deque.push(other);
+        other = next;
+      }
+      return task;
+    }
+
+    const Group& group = *m_groups[worker.group];
+    const std::size_t start = worker.random() % group.count;
+    for (std::size_t i = 0; i < group.count; ++i)
+    {
+      std::size_t victim = group.first + (start + i) % group.count;
+      if (victim == index)
+        continue;
+      if (detail::Task* task = m_workers[victim]->deque.steal())
+        return task;
+      // Tasks in an inbox of a busy worker would wait for it, take them over.
+      if (detail::Task* task = m_workers[victim]->inbox.takeAll())
+      {
+        for (detail::Task* other = task->next; other; )
+        {
+          detail::Task* next = other->next;
+          worker.deque.push(other);
+          other = next;
+        }
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  //! Run a task for the calling worker waiting for a broadcast, see detail::AsyncState::wait().
+  static bool help(void* context)
+  {
+    auto& executor = *static_cast<Executor*>(context);
+    detail::Task* task = executor.find(t_worker);
+    if (!task)
+      return false;
+    task->run(*task);
+    return true;
+  }
+
+  void run(std::size_t index)
+  {
+    t_executor = this;
+    t_worker = index;
+    detail::AsyncState::t_help = &Executor::help;
+    detail::AsyncState::t_helpContext = this;
+    Group& group = *m_groups[m_workers[index]->group];
+    pin(group.cpus);
+    constexpr int SpinRounds = 64;
+
+    for (;;)
+    {
+      std::uint64_t submissions = group.submissions.load(std::memory_order_seq_cst);
+      detail::Task* task = nullptr;
+      for (int round = 0; round < SpinRounds && !task; ++round)
+      {
+        task = find(index);
+        if (!task && round > SpinRounds / 2)
+          std::this_thread::yield();
+      }
+      if (task)
+      {
+        task->run(*task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(group.sleepMutex);
+      if (m_stopping.load(std::memory_order_seq_cst))
+      {
+        // A worker may broadcast to any group, so during destruction workers
+        // stop all at once, when the last of them falls asleep. It decides and
+        // falls asleep with all groups locked, so no other worker misses it.
+        lock.unlock();
+        auto locks = lockAll();
+        if (idle(1))
+        {
+          stop();
+          return;
+        }
+        group.sleeping.fetch_add(1, std::memory_order_seq_cst);
+        lock = std::move(locks[m_workers[index]->group]);
+      }
+      else
+      {
+        group.sleeping.fetch_add(1, std::memory_order_seq_cst);
+      }
+      group.wake.wait(lock, [&]
+      {
+        return group.submissions.load(std::memory_order_seq_cst) != submissions
+          || m_stopped.load(std::memory_order_relaxed);
+      });
+      group.sleeping.fetch_sub(1, std::memory_order_relaxed);
+      if (m_stopped.load(std::memory_order_relaxed))
+        return;
+    }
+  }
+
+  //! Pin the calling thread to \a cpus, unless empty.
+  static void pin([[maybe_unused]] const std::vector<int>& cpus)
+  {
+#if defined(__linux__)
+    if (cpus.empty())
+      return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+      if (cpu >= 0 && cpu < CPU_SETSIZE)
+        CPU_SET(cpu, &set);
+    }
+    // Failing, e.g. in a container restricted to other CPUs, leaves the worker unpinned.
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+  }
+
+  const std::size_t m_grain;
+  std::vector<std::unique_ptr<Group>> m_groups;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::atomic<std::size_t> m_nextInbox{0};
+  std::atomic<bool> m_stopping{false};
+  // Set once all workers are idle during destruction, changed with all groups locked.
+  std::atomic<bool> m_stopped{false};
+
+  static inline thread_local const Executor* t_executor = nullptr;
+  static inline thread_local std::size_t t_worker = 0;
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_EXECUTOR_H
@@ -0,0 +1,315 @@
+#ifndef OBSERVER_HAZARD_H
+#define OBSERVER_HAZARD_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "rcu.h"
+#include "reclaim.h"
+
+namespace Observer
+{
+
+//! Hazard pointer reclamation of objects, which may still be read by other threads.
+/*!
+  An alternative to EpochDomain with bounded memory. A reader publishes the
+  pointer it is about to read in a hazard slot of its thread and an object
+  retired to the domain is deleted as soon as no slot holds it. A thread
+  blocked in a slow listener keeps only the array it is walking, while with
+  epochs it keeps all arrays retired since it entered its guard. Each thread
+  keeps at most the batch size of retired objects plus the number of all slots.
+
+  The price is paid by readers, a guard publishes its pointer, issues the
+  reader fence of detail::AsymmetricFence and loads the pointer once more to
+  check that it has not been replaced meanwhile.
+
+  A domain must outlive all threads, which have used it, except the one
+  destroying it. The global() domain is never destroyed.
+*/
+class HazardDomain
+{
+  struct Record;
+
+public:
+  //! Number of hazard slots in the record of a thread.
+  /*!
+    Guards nested deeper take slots of further blocks of SlotCount slots, which
+    are allocated once and kept with the record until the domain is destroyed.
+  */
+  static constexpr std::size_t SlotCount = 8;
+
+  //! Number of retired objects of a thread, which triggers collect().
+  static constexpr std::size_t DefaultBatchSize = 32;
+
+  //! A hazard slot of the calling thread, which protects one object at a time.
+  class Guard
+  {
+  public:
+    explicit Guard(HazardDomain& domain = HazardDomain::global())
+      : m_domain(domain)
+      , m_record(domain.m_records.local())
+    {
+      m_slot = slot(m_record, m_record.slotsUsed++);
+    }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    ~Guard()
+    {
+      m_slot->store(nullptr, std::memory_order_release);
+      --m_record.slotsUsed;
+    }
+
+    //! Load a pointer to an object, which is retired to the domain when replaced.
+    /*!
+      The object is protected until the guard is destroyed or protect() is
+      called again.
+    */
+    template <class T>
+    T* protect(const std::atomic<T*>& source) const
+    {
+      T* pointer = source.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        m_slot->store(pointer, std::memory_order_relaxed);
+        m_domain.m_fence.light();
+        T* current = source.load(std::memory_order_acquire);
+        if (current == pointer)
+          return pointer;
+        pointer = current;
+      }
+    }
+
+  private:
+    HazardDomain& m_domain;
+    Record& m_record;
+    std::atomic<const void*>* m_slot;
+  };
+
+  explicit HazardDomain(std::size_t batchSize = DefaultBatchSize)
+    : m_batchSize(batchSize ? batchSize : 1)
+  {}
+
+  HazardDomain(const HazardDomain&) = delete;
+  HazardDomain& operator=(const HazardDomain&) = delete;
+
+  //! Deletes all retired objects.
+  /*!
+    Other threads, which have used the domain, must have finished.
+  */
+  ~HazardDomain()
+  {
+    m_records.forEach([](Record& record)
+    {
+      for (auto& retired : record.retired)
+        retired.deleter(retired.pointer);
+    });
+  }
+
+  //! The domain shared by all containers of the library.
+  static HazardDomain& global()
+  {
+    static HazardDomain* domain = new HazardDomain;
+    return *domain;
+  }
+
+  //! Delete \a pointer by \a deleter once no hazard slot holds it.
+  /*!
+    The object must already be unreachable for guards protecting it from now
+    on. \a bytes is accounted in pendingBytes().
+  */
+  void retire(void* pointer, void (*deleter)(void*), std::size_t bytes = 0)
+  {
+    assert(pointer && deleter);
+    Record& record = m_records.local();
+    record.retired.push_back({ pointer, deleter, bytes });
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_pendingBytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (record.retired.size() >= m_batchSize)
+      collect(record);
+  }
+
+  //! Delete \a object by delete once no hazard slot holds it.
+  template <class T>
+  void retire(T* object, std::size_t bytes = sizeof(T))
+  {
+    retire(static_cast<void*>(object), [](void* pointer) { delete static_cast<T*>(pointer); }, bytes);
+  }
+
+  //! Delete objects retired by the calling thread, which no hazard slot holds.
+  void collect()
+  {
+    collect(m_records.local());
+  }
+
+  //! Number of retired objects, which have not been deleted yet.
+  std::size_t pending() const
+  {
+    return m_pending.load(std::memory_order_relaxed);
+  }
+
+  //! Sum of sizes of retired objects, which have not been deleted yet.
+  std::size_t pendingBytes() const
+  {
+    return m_pendingBytes.load(std::memory_order_relaxed);
+  }
+
+  //! True if readers need no fence, because the reclaimer uses membarrier.
+  bool asymmetric() const
+  {
+    return m_fence.enabled();
+  }
+
+private:
+  struct Retired
+  {
+    void* pointer;
+    void (*deleter)(void*);
+    std::size_t bytes;
+  };
+
+  //! Hazard slots of a thread beyond the first SlotCount ones.
+  struct Overflow
+  {
+    std::atomic<const void*> hazards[SlotCount] = {};
+    std::atomic<Overflow*> next{nullptr};
+  };
+
+  //! State of one thread.
+  struct Record : detail::ThreadRecord
+  {
+    ~Record()
+    {
+      for (Overflow* block = overflow.load(std::memory_order_relaxed); block; )
+      {
+        Overflow* next = block->next.load(std::memory_order_relaxed);
+        delete block;
+        block = next;
+      }
+    }
+
+    //! Call \a function for every hazard slot of the record.
+    template <class F>
+    void forEachSlot(F&& function) const
+    {
+      for (auto& slot : hazards)
+        function(slot);
+      for (Overflow* block = overflow.load(std::memory_order_acquire); block; block = block->next.load(std::memory_order_acquire))
+      {
+        for (auto& slot : block->hazards)
+          function(slot);
+      }
+    }
+
+    std::atomic<const void*> hazards[SlotCount] = {};
+    // Blocks are appended only by the thread, which uses the record.
+    std::atomic<Overflow*> overflow{nullptr};
+    // Touched only by the thread, which uses the record.
+    std::size_t slotsUsed = 0;
+    std::vector<Retired> retired;
+    std::vector<const void*> scratch;
+  };
+
+  //! Hazard slot \a index of \a record, blocks of further slots are added as needed.
+  static std::atomic<const void*>* slot(Record& record, std::size_t index)
+  {
+    if (index < SlotCount)
+      return &record.hazards[index];
+
+    std::atomic<Overflow*>* link = &record.overflow;
+    for (index -= SlotCount;; index -= SlotCount)
+    {
+      Overflow* block = link->load(std::memory_order_relaxed);
+      if (!block)
+      {
+        block = new Overflow;
+        link->store(block, std::memory_order_release);
+      }
+      if (index < SlotCount)
+        return &block->hazards[index];
+      link = &block->next;
+    }
+  }
+
+  void reclaim(std::vector<Retired>& retired, const std::vector<const void*>& hazards)
+  {
+    std::size_t count = 0, bytes = 0;
+    auto kept = retired.begin();
+    for (auto& entry : retired)
+    {
+      if (!std::binary_search(hazards.begin(), hazards.end(), entry.pointer))
+      {
+        entry.deleter(entry.pointer);
+        ++count;
+        bytes += entry.bytes;
+      }
+      else
+      {
+        *kept++ = entry;
+      }
+    }
+    retired.erase(kept, retired.end());
+    m_pending.fetch_sub(count, std::memory_order_relaxed);
+    m_pendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  void collect(Record& record)
+  {
+    m_fence.heavy();
+
+    auto& hazards = record.scratch;
+    hazards.clear();
+    m_records.forEach([&hazards](const Record& other)
+    {
+      other.forEachSlot([&hazards](const std::atomic<const void*>& slot)
+      {
+        if (const void* pointer = slot.load(std::memory_order_acquire))
+          hazards.push_back(pointer);
+      });
+    });
+    std::sort(hazards.begin(), hazards.end());
+
+    reclaim(record.retired, hazards);
+
+    // Objects left behind by finished threads.
+    m_records.forEach([this, &hazards](Record& other)
+    {
+      // The list may be read only once the record is acquired, a live thread may be changing it.
+      if (other.tryAcquire())
+      {
+        if (!other.retired.empty())
+          reclaim(other.retired, hazards);
+        other.release();
+      }
+    });
+  }
+
+  std::atomic<std::size_t> m_pending{0};
+  std::atomic<std::size_t> m_pendingBytes{0};
+  const std::size_t m_batchSize;
+  detail::AsymmetricFence m_fence;
+  detail::ThreadRecords<Record> m_records;
+};
+
+//! A container of listeners, which may be notified from several threads at once, see CopyOnWriteContainer.
+/*!
+  Notifications protect the listener array by a hazard pointer, so slow
+  listeners do not hold back deletion of arrays replaced meanwhile. A
+  notification holds a hazard slot of its thread until all listeners have
+  returned, so notifications sent by listeners nest. Nesting deeper than
+  HazardDomain::SlotCount allocates a block of further slots for the thread.
+*/
+template <class T_Listener>
+using HazardContainer = CopyOnWriteContainer<T_Listener, HazardDomain>;
+
+//! Shortcut for a source, whose listener arrays are protected by hazard pointers
+template <class... T_Listeners>
+using HazardSource = Source<HazardContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_HAZARD_H
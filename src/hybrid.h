@@ -0,0 +1,330 @@
+#ifndef OBSERVER_HYBRID_H
+#define OBSERVER_HYBRID_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "observer.h"
+
+namespace Observer
+{
+
+//! Representation of listeners in HybridContainer.
+enum class HybridMode : std::uint8_t
+{
+  //! Few listeners stored in the container itself.
+  Inline,
+  //! Listeners in a dense vector, detaching searches it.
+  Vector,
+  //! Listeners in a vector with an index for detaching without a search.
+  Indexed
+};
+
+//! Listener counts, at which HybridContainer changes its representation.
+/*!
+  The gaps between the thresholds of opposite changes prevent a container,
+  whose listener count oscillates around a threshold, from converting back
+  and forth. The defaults come from the "hybrid" benchmark, which should be
+  run on the target machine to calibrate them.
+*/
+struct HybridThresholds
+{
+  //! The index is built when the listener count exceeds this.
+  std::size_t indexAbove = 256;
+  //! The index is dropped when the listener count falls below this.
+  std::size_t unindexBelow = 64;
+  //! Listeners move back to the inline storage when their count falls to this.
+  std::size_t inlineAtMost = 1;
+};
+
+//! A container of listeners, which changes its representation by the listener count.
+/*!
+  Up to InlineCapacity listeners are stored in the container without any
+  allocation. More listeners are moved to a dense vector, which is the fastest
+  to notify, and vectors of many listeners get an index, so that detaching does
+  not search them. Detached listeners of an indexed vector leave holes, which are
+  squeezed out when they make up half of the vector.
+
+  The thresholds are shared by all containers of one listener type and they may
+  be overridden by setThresholds(), which is meant to be called at start-up.
+  Behaves like RawContainer otherwise, so listeners are held as raw pointers,
+  the order of attachment is kept and the container is not thread safe.
+*/
+template <class T_Listener>
+class HybridContainer
+{
+public:
+  //! Number of listeners stored inline.
+  static constexpr std::size_t InlineCapacity = 3;
+
+  HybridContainer() = default;
+
+  HybridContainer(const HybridContainer& other)
+  {
+    assign(other.collect());
+  }
+
+  HybridContainer& operator=(const HybridContainer& other)
+  {
+    if (this != &other)
+      assign(other.collect());
+    return *this;
+  }
+
+  virtual ~HybridContainer() {}
+
+  //! Override the thresholds of all containers of listener type \a T_Listener.
+  static void setThresholds(const HybridThresholds& thresholds)
+  {
+    assert(thresholds.unindexBelow <= thresholds.indexAbove);
+    assert(thresholds.inlineAtMost <= InlineCapacity);
+    sharedThresholds() = thresholds;
+  }
+
+  //! The thresholds of all containers of listener type \a T_Listener.
+  static const HybridThresholds& thresholds()
+  {
+    return sharedThresholds();
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    assert(listener);
+    switch (m_mode)
+    {
+    case HybridMode::Inline:
+      if (m_inlineCount < InlineCapacity)
+      {
+        m_inline[m_inlineCount++] = listener;
+        return;
+      }
+      m_listeners.assign(m_inline.begin(), m_inline.begin() + m_inlineCount);
+      m_inlineCount = 0;
+      m_mode = HybridMode::Vector;
+      m_listeners.push_back(listener);
+      break;
+    case HybridMode::Vector:
+      m_listeners.push_back(listener);
+      break;
+    case HybridMode::Indexed:
+      m_index->positions.emplace(listener, static_cast<std::uint32_t>(m_listeners.size()));
+      m_listeners.push_back(listener);
+      return;
+    }
+    if (m_listeners.size() > thresholds().indexAbove)
+      buildIndex();
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    switch (m_mode)
+    {
+    case HybridMode::Inline:
+      m_inlineCount = static_cast<std::uint8_t>(
+        std::remove(m_inline.begin(), m_inline.begin() + m_inlineCount, listener) - m_inline.begin());
+      return;
+    case HybridMode::Vector:
+      m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+      break;
+    case HybridMode::Indexed:
+    {
+      auto range = m_index->positions.equal_range(listener);
+      for (auto it = range.first; it != range.second; ++it)
+        m_listeners[it->second] = nullptr;
+      m_index->holes += std::distance(range.first, range.second);
+      m_index->positions.erase(range.first, range.second);
+      if (size() < thresholds().unindexBelow)
+        dropIndex();
+      else if (2 * m_index->holes > m_listeners.size())
+        buildIndex();
+      break;
+    }
+    }
+    if (m_mode == HybridMode::Vector && m_listeners.size() <= thresholds().inlineAtMost)
+      assign(collect());
+  }
+
+  //! Number of attached listeners.
+  std::size_t size() const
+  {
+    switch (m_mode)
+    {
+    case HybridMode::Inline:
+      return m_inlineCount;
+    case HybridMode::Vector:
+      return m_listeners.size();
+    default:
+      return m_listeners.size() - m_index->holes;
+    }
+  }
+
+  //! The current representation of listeners.
+  HybridMode mode() const
+  {
+    return m_mode;
+  }
+
+  //! Memory occupied by this container.
+  /*!
+    Holes left by detached listeners in the indexed representation are reported as dead.
+  */
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    usage.liveEntries = size();
+    if (m_mode == HybridMode::Indexed)
+    {
+      usage.deadEntries = m_index->holes;
+      // Rough estimate of the hash map: one node per listener and the bucket array.
+      auto index = sizeof(Index)
+        + m_index->positions.size() * (sizeof(typename Positions::value_type) + 2 * sizeof(void*))
+        + m_index->positions.bucket_count() * sizeof(void*);
+      usage.bytesUsed += index;
+      usage.bytesReserved += index;
+    }
+    return usage;
+  }
+
+  //! Move listeners to the smallest representation for their count and release unused capacity.
+  void shrink()
+  {
+    assign(collect());
+  }
+
+  //! Sort listeners by their address, see RawContainer::compact().
+  void compact()
+  {
+    auto listeners = collect();
+    std::sort(listeners.begin(), listeners.end(), std::less<T_Listener*>());
+    assign(std::move(listeners));
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    auto* const* begin = m_mode == HybridMode::Inline ? m_inline.data() : m_listeners.data();
+    auto* const* end = begin + (m_mode == HybridMode::Inline ? m_inlineCount : m_listeners.size());
+
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* const* l = begin; l != end; ++l)
+        if (*l)
+          detail::CallMonitor::timedCall(monitor, *l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    // Only the indexed representation has holes.
+    if (m_mode != HybridMode::Indexed)
+    {
+      for (auto* const* l = begin; l != end; ++l)
+        ((*l)->*fn)(std::forward<Fn_Args>(args)...);
+      return;
+    }
+    for (auto* const* l = begin; l != end; ++l)
+      if (*l)
+        ((*l)->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+private:
+  using Positions = std::unordered_multimap<T_Listener*, std::uint32_t>;
+
+  struct Index
+  {
+    Positions positions;
+    std::size_t holes = 0;
+  };
+
+  static HybridThresholds& sharedThresholds()
+  {
+    static HybridThresholds thresholds;
+    return thresholds;
+  }
+
+  //! Listeners in the order of attachment without holes.
+  std::vector<T_Listener*> collect() const
+  {
+    if (m_mode == HybridMode::Inline)
+      return std::vector<T_Listener*>(m_inline.begin(), m_inline.begin() + m_inlineCount);
+    std::vector<T_Listener*> listeners;
+    listeners.reserve(size());
+    for (auto* l : m_listeners)
+      if (l)
+        listeners.push_back(l);
+    return listeners;
+  }
+
+  //! Replace all listeners choosing the representation by their count only.
+  void assign(std::vector<T_Listener*> listeners)
+  {
+    m_index.reset();
+    m_inlineCount = 0;
+    if (listeners.size() <= InlineCapacity)
+    {
+      std::copy(listeners.begin(), listeners.end(), m_inline.begin());
+      m_inlineCount = static_cast<std::uint8_t>(listeners.size());
+      std::vector<T_Listener*>().swap(m_listeners);
+      m_mode = HybridMode::Inline;
+      return;
+    }
+    listeners.shrink_to_fit();
+    m_listeners = std::move(listeners);
+    m_mode = HybridMode::Vector;
+    if (m_listeners.size() > thresholds().indexAbove)
+      buildIndex();
+  }
+
+  //! Squeeze out holes and index the listeners.
+  void buildIndex()
+  {
+    if (m_index)
+      m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), nullptr), m_listeners.end());
+    else
+      m_index = std::make_unique<Index>();
+    m_index->holes = 0;
+    m_index->positions.clear();
+    m_index->positions.reserve(m_listeners.size());
+    for (std::size_t i = 0; i < m_listeners.size(); ++i)
+      m_index->positions.emplace(m_listeners[i], static_cast<std::uint32_t>(i));
+    m_mode = HybridMode::Indexed;
+  }
+
+  //! Squeeze out holes and drop the index.
+  void dropIndex()
+  {
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), nullptr), m_listeners.end());
+    m_index.reset();
+    m_mode = HybridMode::Vector;
+  }
+
+  std::vector<T_Listener*> m_listeners;
+  std::unique_ptr<Index> m_index;
+  std::array<T_Listener*, InlineCapacity> m_inline{};
+  std::uint8_t m_inlineCount = 0;
+  HybridMode m_mode = HybridMode::Inline;
+};
+
+//! Shortcut for a source, which changes the representation of listeners by their count
+template <class... T_Listeners>
+using HybridSource = Source<HybridContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_HYBRID_H
@@ -0,0 +1,312 @@
+#ifndef OBSERVER_LATENCY_H
+#define OBSERVER_LATENCY_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+#include "clock.h"
+#include "dispatcher.h"
+
+namespace Observer
+{
+
+//! Histogram of durations with buckets growing by powers of two.
+/*!
+  Bucket \a i counts durations in range <2^i, 2^(i+1)) nanoseconds, the first
+  bucket counts also durations shorter than one nanosecond and the last one all
+  longer durations.
+*/
+class LatencyHistogram
+{
+public:
+  static constexpr std::size_t BucketCount = 40;
+
+  //! Add a duration given in nanoseconds.
+  void record(double nanoseconds)
+  {
+    std::size_t index = 0;
+    if (nanoseconds >= 2.0)
+      index = std::min<std::size_t>(static_cast<std::size_t>(std::log2(nanoseconds)), BucketCount - 1);
+    ++m_buckets[index];
+    ++m_count;
+    m_sum += nanoseconds;
+  }
+
+  //! Number of recorded durations.
+  std::uint64_t count() const { return m_count; }
+
+  //! Sum of all recorded durations in nanoseconds.
+  double sum() const { return m_sum; }
+
+  //! Mean of all recorded durations in nanoseconds.
+  double mean() const { return m_count ? m_sum / m_count : 0.0; }
+
+  //! Number of durations in bucket \a index.
+  std::uint64_t bucket(std::size_t index) const { return m_buckets[index]; }
+
+  //! Exclusive upper bound of bucket \a index in nanoseconds.
+  static double upperBound(std::size_t index) { return std::ldexp(1.0, static_cast<int>(index) + 1); }
+
+  //! Upper bound of the bucket, which contains percentile \a p given in range <0, 100>.
+  double percentile(double p) const
+  {
+    if (!m_count)
+      return 0.0;
+    auto rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * m_count));
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < BucketCount; ++i)
+    {
+      cumulative += m_buckets[i];
+      if (cumulative >= rank && cumulative > 0)
+        return upperBound(i);
+    }
+    return upperBound(BucketCount - 1);
+  }
+
+private:
+  std::array<std::uint64_t, BucketCount> m_buckets{};
+  std::uint64_t m_count = 0;
+  double m_sum = 0.0;
+};
+
+//! Collects end-to-end latencies of queued notifications.
+/*!
+  Set the tracker to a Dispatcher by Dispatcher::setLatencyRecorder(). The time
+  from posting a notification to the start of a listener call (queue wait) and the
+  duration of the call (handler) are then recorded for every subscription, i.e.
+  every listener attached to a queued source. Whole events are recorded per lane
+  as well. Latencies of a subscription are dropped, when the listener is
+  detached or the source is destroyed.
+
+  Results are available as a snapshot() or in the Prometheus text exposition
+  format. Recording takes an uncontended lock, as it is expected to happen only
+  on the thread draining the dispatcher.
+*/
+class LatencyTracker : public LatencyRecorder
+{
+public:
+  //! Latencies of one listener attached to one source.
+  struct Subscription
+  {
+    std::string listenerType;
+    const void* source = nullptr;
+    const void* listener = nullptr;
+    LatencyHistogram queueWait;
+    LatencyHistogram handler;
+  };
+
+  //! Latencies of events of one lane of the dispatcher.
+  struct Lane
+  {
+    LatencyHistogram queueWait;
+    LatencyHistogram dispatch;
+  };
+
+  struct Snapshot
+  {
+    std::vector<Subscription> subscriptions;
+    std::array<Lane, PriorityCount> lanes;
+  };
+
+  //! Copy of all latencies recorded so far.
+  Snapshot snapshot() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Snapshot result;
+    result.lanes = m_lanes;
+    result.subscriptions.reserve(m_subscriptions.size());
+    for (const auto& entry : m_subscriptions)
+      result.subscriptions.push_back(entry.second);
+    return result;
+  }
+
+  //! Forget all recorded latencies.
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_subscriptions.clear();
+    m_lanes = {};
+  }
+
+  //! Write all latencies to \a out in the Prometheus text exposition format.
+  void writePrometheus(std::ostream& out) const
+  {
+    auto data = snapshot();
+    static const char* laneNames[PriorityCount] = { "high", "normal", "low" };
+
+    writeFamily(out, "observer_event_queue_wait_seconds",
+      "Time from posting an event to the start of its dispatch.");
+    for (std::size_t i = 0; i < PriorityCount; ++i)
+      writeHistogram(out, "observer_event_queue_wait_seconds",
+        "lane=\"" + std::string(laneNames[i]) + "\"", data.lanes[i].queueWait);
+
+    writeFamily(out, "observer_event_dispatch_seconds",
+      "Time spent dispatching an event to all its listeners.");
+    for (std::size_t i = 0; i < PriorityCount; ++i)
+      writeHistogram(out, "observer_event_dispatch_seconds",
+        "lane=\"" + std::string(laneNames[i]) + "\"", data.lanes[i].dispatch);
+
+    writeFamily(out, "observer_call_queue_wait_seconds",
+      "Time from posting a notification to the start of the listener call.");
+    for (const auto& subscription : data.subscriptions)
+      writeHistogram(out, "observer_call_queue_wait_seconds", labels(subscription), subscription.queueWait);
+
+    writeFamily(out, "observer_call_handler_seconds",
+      "Time spent in the listener call.");
+    for (const auto& subscription : data.subscriptions)
+      writeHistogram(out, "observer_call_handler_seconds", labels(subscription), subscription.handler);
+  }
+
+  //! Write all latencies to file \a fileName in the Prometheus text exposition format.
+  /*!
+    Returns false if the file couldn't be written.
+  */
+  bool writePrometheus(const std::string& fileName) const
+  {
+    std::ofstream out(fileName, std::ios::trunc);
+    writePrometheus(out);
+    out.close();
+    return !out.fail();
+  }
+
+  void recordEvent(Priority lane, std::uint64_t waitTicks, std::uint64_t handlerTicks) override
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& entry = m_lanes[static_cast<std::size_t>(lane)];
+    entry.queueWait.record(TscClock::toNanoseconds(waitTicks));
+    entry.dispatch.record(TscClock::toNanoseconds(handlerTicks));
+  }
+
+  void recordCall(const void* source, const void* listener, const std::type_info& listenerType,
+    std::uint64_t waitTicks, std::uint64_t handlerTicks) override
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& entry = m_subscriptions[Key{ source, listener }];
+    if (!entry.listener)
+    {
+      entry.listenerType = demangle(listenerType.name());
+      entry.source = source;
+      entry.listener = listener;
+    }
+    entry.queueWait.record(TscClock::toNanoseconds(waitTicks));
+    entry.handler.record(TscClock::toNanoseconds(handlerTicks));
+  }
+
+  void forget(const void* source, const void* listener) override
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_subscriptions.erase(Key{ source, listener });
+  }
+
+private:
+  struct Key
+  {
+    const void* source;
+    const void* listener;
+
+    bool operator==(const Key& other) const
+    {
+      return source == other.source && listener == other.listener;
+    }
+  };
+
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const
+    {
+      return std::hash<const void*>()(key.source) ^ (std::hash<const void*>()(key.listener) << 1);
+    }
+  };
+
+  static std::string demangle(const char* name)
+  {
+#if defined(__GNUG__)
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+      std::string result(demangled);
+      std::free(demangled);
+      return result;
+    }
+#endif
+    return name;
+  }
+
+  static std::string escape(const std::string& value)
+  {
+    std::string result;
+    for (char c : value)
+    {
+      if (c == '\\' || c == '"')
+        result += '\\';
+      if (c == '\n')
+      {
+        result += "\\n";
+        continue;
+      }
+      result += c;
+    }
+    return result;
+  }
+
+  static std::string address(const void* pointer)
+  {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%p", pointer);
+    return buffer;
+  }
+
+  static std::string labels(const Subscription& subscription)
+  {
+    return "listener_type=\"" + escape(subscription.listenerType)
+      + "\",source=\"" + address(subscription.source)
+      + "\",listener=\"" + address(subscription.listener) + "\"";
+  }
+
+  static void writeFamily(std::ostream& out, const char* name, const char* help)
+  {
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << " histogram\n";
+  }
+
+  //! Write \a histogram with buckets of powers of four from 128 ns to 8.6 s.
+  static void writeHistogram(std::ostream& out, const char* name, const std::string& labels,
+    const LatencyHistogram& histogram)
+  {
+    std::uint64_t cumulative = 0;
+    std::size_t index = 0;
+    for (int exponent = 7; exponent <= 33; exponent += 2)
+    {
+      for (; index < static_cast<std::size_t>(exponent); ++index)
+        cumulative += histogram.bucket(index);
+      out << name << "_bucket{" << labels << ",le=\"" << std::ldexp(1.0, exponent) * 1e-9 << "\"} "
+          << cumulative << '\n';
+    }
+    out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count() << '\n'
+        << name << "_sum{" << labels << "} " << histogram.sum() * 1e-9 << '\n'
+        << name << "_count{" << labels << "} " << histogram.count() << '\n';
+  }
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<Key, Subscription, KeyHash> m_subscriptions;
+  std::array<Lane, PriorityCount> m_lanes;
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_LATENCY_H
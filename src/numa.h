@@ -0,0 +1,303 @@
+#ifndef OBSERVER_NUMA_H
+#define OBSERVER_NUMA_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "executor.h"
+#include "observer.h"
+
+namespace Observer
+{
+
+namespace detail
+{
+//! Parse a list of ranges like "0-3,8,10-11" used by Linux sysfs.
+inline std::vector<int> parseRangeList(const std::string& text)
+{
+  std::vector<int> values;
+  std::size_t position = 0;
+  while (position < text.size())
+  {
+    std::size_t end = text.find(',', position);
+    if (end == std::string::npos)
+      end = text.size();
+    const std::string range = text.substr(position, end - position);
+    position = end + 1;
+
+    const std::size_t dash = range.find('-');
+    try
+    {
+      const int first = std::stoi(range.substr(0, dash));
+      const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int value = first; value <= last; ++value)
+        values.push_back(value);
+    }
+    catch (const std::exception&)
+    {
+      // Skip blanks and anything, which is not a range.
+    }
+  }
+  return values;
+}
+
+//! Read the first line of a sysfs file, or an empty string if it does not exist.
+inline std::string readLine(const std::string& path)
+{
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+//! NUMA node of the CPU running the calling thread, 0 if unknown.
+inline unsigned currentNode()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+    return node;
+#endif
+  return 0;
+}
+
+//! NUMA node holding the memory at \a address, the node of the calling thread if unknown.
+inline unsigned nodeOfAddress([[maybe_unused]] const void* address)
+{
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+  // MPOL_F_NODE | MPOL_F_ADDR of <numaif.h>, so libnuma is not needed.
+  constexpr unsigned long NodeOfAddress = 1 | 2;
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0ul, const_cast<void*>(address), NodeOfAddress) == 0 && node >= 0)
+    return static_cast<unsigned>(node);
+#endif
+  return currentNode();
+}
+}
+
+//! NUMA nodes of the machine and their CPUs.
+class NumaTopology
+{
+public:
+  struct Node
+  {
+    //! Number of the node given by the operating system.
+    unsigned id = 0;
+    //! CPUs of the node, empty in a simulated topology.
+    std::vector<int> cpus;
+  };
+
+  //! Nodes listed in /sys/devices/system/node, or a single node if there are none.
+  static NumaTopology detect()
+  {
+    NumaTopology topology;
+    const std::string root = "/sys/devices/system/node/";
+    for (int id : detail::parseRangeList(detail::readLine(root + "online")))
+    {
+      Node node;
+      node.id = static_cast<unsigned>(id);
+      node.cpus = detail::parseRangeList(detail::readLine(root + "node" + std::to_string(id) + "/cpulist"));
+      // Nodes with memory only have no CPUs to run workers on.
+      if (!node.cpus.empty())
+        topology.m_nodes.push_back(std::move(node));
+    }
+    if (topology.m_nodes.empty())
+      topology.m_nodes.push_back(Node());
+    return topology;
+  }
+
+  //! \a nodes nodes without CPUs, so that workers are not pinned, e.g. to try placement on a single node.
+  static NumaTopology simulated(std::size_t nodes)
+  {
+    NumaTopology topology;
+    for (std::size_t i = 0; i < std::max<std::size_t>(nodes, 1); ++i)
+      topology.m_nodes.push_back(Node{ static_cast<unsigned>(i), {} });
+    topology.m_simulated = true;
+    return topology;
+  }
+
+  const std::vector<Node>& nodes() const
+  {
+    return m_nodes;
+  }
+
+  std::size_t nodeCount() const
+  {
+    return m_nodes.size();
+  }
+
+  bool isSimulated() const
+  {
+    return m_simulated;
+  }
+
+  //! Worker groups of an Executor, one per node, whose workers are pinned to the CPUs of the node.
+  /*!
+    A group has \a workersPerNode workers, or one per CPU of its node if zero.
+    Nodes of a simulated topology share the hardware threads.
+  */
+  std::vector<WorkerGroup> workerGroups(std::size_t workersPerNode = 0) const
+  {
+    std::vector<WorkerGroup> groups;
+    for (const auto& node : m_nodes)
+    {
+      WorkerGroup group;
+      group.workers = workersPerNode;
+      if (!group.workers && node.cpus.empty())
+        group.workers = std::max<std::size_t>(std::thread::hardware_concurrency() / m_nodes.size(), 1);
+      group.cpus = node.cpus;
+      group.node = node.id;
+      groups.push_back(std::move(group));
+    }
+    return groups;
+  }
+
+private:
+  std::vector<Node> m_nodes;
+  bool m_simulated = false;
+};
+
+//! A container of listeners, which knows the home NUMA node of every listener.
+/*!
+  The home node of a listener is the node holding its memory, when it is
+  attached, or the node of the attaching thread if the memory policy cannot
+  be queried. setHome() overrides it. Source::notifyAsync() passes the home
+  nodes to Executor::broadcast(), which delivers every listener by workers of
+  the group of its home node, see NumaTopology::workerGroups().
+
+  Behaves like RawContainer otherwise.
+*/
+template <class T_Listener>
+class NumaContainer
+{
+public:
+  virtual ~NumaContainer() {}
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    assert(listener);
+    m_listeners.push_back(listener);
+    m_homes.push_back(detail::nodeOfAddress(listener));
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_listeners.size(); ++i)
+    {
+      if (m_listeners[i] != listener)
+      {
+        m_listeners[kept] = m_listeners[i];
+        m_homes[kept++] = m_homes[i];
+      }
+    }
+    m_listeners.resize(kept);
+    m_homes.resize(kept);
+  }
+
+  //! Make node \a node the home node of \a listener.
+  void setHome(T_Listener* listener, unsigned node)
+  {
+    for (std::size_t i = 0; i < m_listeners.size(); ++i)
+    {
+      if (m_listeners[i] == listener)
+        m_homes[i] = node;
+    }
+  }
+
+  //! Memory occupied by this container.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    auto homes = detail::vectorUsage(m_homes, 0);
+    usage.bytesUsed += homes.bytesUsed;
+    usage.bytesReserved += homes.bytesReserved;
+    usage.liveEntries = m_listeners.size();
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    m_listeners.shrink_to_fit();
+    m_homes.shrink_to_fit();
+  }
+
+  //! Sort listeners by their home node and address, see RawContainer::compact().
+  void compact()
+  {
+    std::vector<std::pair<unsigned, T_Listener*>> entries;
+    entries.reserve(m_listeners.size());
+    for (std::size_t i = 0; i < m_listeners.size(); ++i)
+      entries.emplace_back(m_homes[i], m_listeners[i]);
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b)
+      { return a.first != b.first ? a.first < b.first : std::less<T_Listener*>()(a.second, b.second); });
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+      m_homes[i] = entries[i].first;
+      m_listeners[i] = entries[i].second;
+    }
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified by the calling
+    thread. The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* l : m_listeners)
+        detail::CallMonitor::timedCall(monitor, l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto* l : m_listeners)
+      (l->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+  //! Call \a function for every listener and its home node, see Source::notifyAsync().
+  template <class F>
+  void forEachListener(F&& function) const
+  {
+    for (std::size_t i = 0; i < m_listeners.size(); ++i)
+      function(m_listeners[i], m_homes[i]);
+  }
+
+private:
+  std::vector<T_Listener*> m_listeners;
+  std::vector<unsigned> m_homes;
+};
+
+//! Shortcut for a source, whose listeners are delivered on their home NUMA nodes
+template <class... T_Listeners>
+using NumaSource = Source<NumaContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_NUMA_H
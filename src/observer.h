@@ -1,8 +1,19 @@
+#ifndef OBSERVER_H
+#define OBSERVER_H
+
 #include <vector>
 #include <type_traits>
 #include <cassert>
 #include <algorithm>
 #include <memory>
+#include <array>
+#include <cstring>
+#include <typeinfo>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <tuple>
 
 namespace Observer
 {
@@ -21,6 +32,221 @@ public:
   virtual ~Listener() {}
 };
 
+//! Identity of a notification method.
+/*!
+  Pointers to methods of different types cannot be compared directly. This class
+  allows to store them in one collection, compare them and use them as keys.
+*/
+class MethodId
+{
+public:
+  MethodId() = default;
+
+  template <class T, typename... Fn_Args>
+  MethodId(void (T::*fn)(Fn_Args...))
+    : m_type(&typeid(fn))
+  {
+    static_assert(sizeof(fn) <= sizeof(m_bytes), "unsupported pointer to member function");
+    std::memcpy(m_bytes.data(), &fn, sizeof(fn));
+  }
+
+  bool operator==(const MethodId& other) const
+  {
+    return m_bytes == other.m_bytes
+      && (m_type == other.m_type || (m_type && other.m_type && *m_type == *other.m_type));
+  }
+
+  bool operator!=(const MethodId& other) const
+  {
+    return !(*this == other);
+  }
+
+  //! Name of the method type as reported by the implementation.
+  const char* typeName() const
+  {
+    return m_type ? m_type->name() : "";
+  }
+
+  //! Hash of the method, which is suitable for unordered containers.
+  std::size_t hash() const
+  {
+    std::size_t h = 0;
+    for (auto b : m_bytes)
+      h = h * 131 + b;
+    return h;
+  }
+
+private:
+  const std::type_info* m_type = nullptr;
+  std::array<unsigned char, 4 * sizeof(void*)> m_bytes{};
+};
+
+//! Memory occupied by the listener storage of a container or a source.
+/*!
+  Both byte counts include the size of the container objects themselves.
+  The difference between reserved and used bytes is the slack, which may be
+  released by shrink().
+*/
+struct MemoryUsage
+{
+  //! Bytes occupied by the containers and their entries, live or dead.
+  std::size_t bytesUsed = 0;
+  //! Bytes allocated by the containers including unused capacity.
+  std::size_t bytesReserved = 0;
+  //! Number of entries referring to an existing listener.
+  std::size_t liveEntries = 0;
+  //! Number of entries referring to a listener, which no longer exists.
+  std::size_t deadEntries = 0;
+
+  MemoryUsage& operator+=(const MemoryUsage& other)
+  {
+    bytesUsed += other.bytesUsed;
+    bytesReserved += other.bytesReserved;
+    liveEntries += other.liveEntries;
+    deadEntries += other.deadEntries;
+    return *this;
+  }
+};
+
+namespace detail
+{
+//! Memory usage of \a vector, which is a member of an object of \a objectSize bytes.
+template <class T>
+MemoryUsage vectorUsage(const std::vector<T>& vector, std::size_t objectSize)
+{
+  MemoryUsage usage;
+  usage.bytesUsed = objectSize + vector.size() * sizeof(T);
+  usage.bytesReserved = objectSize + vector.capacity() * sizeof(T);
+  return usage;
+}
+
+//! Receiver of sampled durations of listener calls.
+/*!
+  Containers time all listener calls of a notification once in a while and report
+  them to the active monitor, see Watchdog. Notifications, which are not sampled,
+  do not read the clock.
+*/
+class CallMonitor
+{
+public:
+  virtual ~CallMonitor() {}
+
+  //! Number of notifications per thread, out of which one is timed.
+  virtual std::uint32_t sampleInterval() const = 0;
+
+  //! Report that \a listener spent \a elapsed time handling notification \a method.
+  virtual void report(const void* listener, const MethodId& method, std::chrono::nanoseconds elapsed) = 0;
+
+  //! Make \a monitor the monitor of all containers, nullptr disables sampling.
+  static void activate(CallMonitor* monitor)
+  {
+    active().store(monitor, std::memory_order_release);
+  }
+
+  //! Disable sampling if \a monitor is the active monitor.
+  static void deactivate(CallMonitor* monitor)
+  {
+    active().compare_exchange_strong(monitor, nullptr, std::memory_order_acq_rel);
+  }
+
+  //! Returns the active monitor if the current notification is to be sampled.
+  /*!
+    The common case is a decrement of a thread local counter. The distance between
+    samples is randomized around the sample interval, so that notifications,
+    which are emitted in a regular pattern, are all sampled.
+  */
+  static CallMonitor* sample()
+  {
+    thread_local std::uint32_t untilSample = IdleInterval;
+    thread_local std::uint32_t random = 2463534242u;
+    if (--untilSample != 0)
+      return nullptr;
+    auto* monitor = active().load(std::memory_order_acquire);
+    if (!monitor)
+    {
+      untilSample = IdleInterval;
+      return nullptr;
+    }
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    auto interval = monitor->sampleInterval();
+    untilSample = interval / 2 + 1 + random % interval;
+    return monitor;
+  }
+
+  //! Call \a fn of \a listener and report the duration of the call to \a monitor.
+  template <class T_Listener, typename... Fn_Args>
+  static void timedCall(CallMonitor* monitor, T_Listener* listener,
+    void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    auto start = std::chrono::steady_clock::now();
+    (listener->*fn)(std::forward<Fn_Args>(args)...);
+    monitor->report(listener, MethodId(fn), std::chrono::steady_clock::now() - start);
+  }
+
+private:
+  // Without a monitor, the active one is looked up once in this many notifications.
+  static constexpr std::uint32_t IdleInterval = 64;
+
+  static std::atomic<CallMonitor*>& active()
+  {
+    static std::atomic<CallMonitor*> monitor{nullptr};
+    return monitor;
+  }
+};
+}
+
+//! A notification to be sent together with others by Source::notifyAll().
+/*!
+  Holds the notification method and references to its arguments, so it must not
+  outlive the statement, which creates it. Use Observer::call() to create it.
+*/
+template <class T_Listener, typename... Fn_Args>
+class Call
+{
+public:
+  using Listener = T_Listener;
+  using Method = void (T_Listener::*)(Fn_Args...);
+
+  Call(Method fn, Fn_Args&&... args)
+    : m_fn(fn)
+    , m_args(std::forward<Fn_Args>(args)...)
+  {}
+
+  //! The notification method.
+  Method method() const
+  {
+    return m_fn;
+  }
+
+  //! Call the method on \a listener.
+  void operator()(T_Listener* listener) const
+  {
+    std::apply([this, listener](auto&&... args)
+      { (listener->*m_fn)(std::forward<Fn_Args>(args)...); }, m_args);
+  }
+
+  //! Pass the method and its arguments to \a fn.
+  template <class F>
+  void apply(F&& fn) const
+  {
+    std::apply([this, &fn](auto&&... args)
+      { fn(m_fn, std::forward<Fn_Args>(args)...); }, m_args);
+  }
+
+private:
+  Method m_fn;
+  std::tuple<Fn_Args&&...> m_args;
+};
+
+//! Create a notification of method \a fn with arguments \a args for Source::notifyAll().
+template <class T_Listener, typename... Fn_Args>
+Call<T_Listener, Fn_Args...> call(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+{
+  return Call<T_Listener, Fn_Args...>(fn, std::forward<Fn_Args>(args)...);
+}
+
 //! A container of listeners, which holds raw pointers.
 /*!
   This is a collection of pointers to listener objects of a single type,
@@ -49,7 +275,32 @@ public:
   */
   void detach(T_Listener* listener)
   {
-    m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(), listener));
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+  }
+
+  //! Memory occupied by this container.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    usage.liveEntries = m_listeners.size();
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    m_listeners.shrink_to_fit();
+  }
+
+  //! Sort listeners by their address, so that notifications walk memory in order.
+  /*!
+    This changes the order of notifications, so it is meant for sources, whose
+    listeners do not depend on the order of attachment, and it is meant to be
+    called at idle time, since it sorts the whole container.
+  */
+  void compact()
+  {
+    std::sort(m_listeners.begin(), m_listeners.end(), std::less<T_Listener*>());
   }
 
 protected:
@@ -62,9 +313,46 @@ protected:
   template <typename... Fn_Args>
   void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
   {    
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto& l : m_listeners)
+        detail::CallMonitor::timedCall(monitor, l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
     for (auto& l : m_listeners)
      (l->*fn)(std::forward<Fn_Args>(args)...);
     }
+
+  //! Send all notifications \a calls to every listener before moving to the next one.
+  template <class... T_Calls>
+  void notifyAll(const T_Calls&... calls)
+  {
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* l : m_listeners)
+        (calls.apply([monitor, l](auto fn, auto&&... args)
+          { detail::CallMonitor::timedCall(monitor, l, fn, std::forward<decltype(args)>(args)...); }), ...);
+      return;
+    }
+
+    for (auto* l : m_listeners)
+      (calls(l), ...);
+  }
+
+  //! Call \a function for every listener, see Source::notifyAsync().
+  template <class F>
+  void forEachListener(F&& function) const
+  {
+    for (auto* l : m_listeners)
+      function(l);
+  }
+
+  //! Listeners registered in this container.
+  const std::vector<T_Listener*>& listeners() const
+  {
+    return m_listeners;
+  }
   
 private:
   std::vector<T_Listener*> m_listeners;
@@ -104,8 +392,47 @@ public:
       [&listener](const auto& weakListener)
       { 
          auto ptr = weakListener.lock();
-         return ptr == listener || ptr.empty();
-      }));
+         return ptr == listener || !ptr;
+      }), m_listeners.end());
+  }
+
+  //! Memory occupied by this container.
+  /*!
+    Entries of listeners, which have already been destroyed, are reported as dead.
+  */
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    for (const auto& weakListener : m_listeners)
+      ++(weakListener.expired() ? usage.deadEntries : usage.liveEntries);
+    return usage;
+  }
+
+  //! Erase entries of destroyed listeners and release unused capacity.
+  void shrink()
+  {
+    m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+      [](const auto& weakListener) { return weakListener.expired(); }), m_listeners.end());
+    m_listeners.shrink_to_fit();
+  }
+
+  //! Erase entries of destroyed listeners and sort the others by address.
+  /*!
+    This changes the order of notifications, see RawContainer::compact().
+  */
+  void compact()
+  {
+    std::vector<std::pair<T_Listener*, std::weak_ptr<T_Listener>>> entries;
+    entries.reserve(m_listeners.size());
+    for (auto& weakListener : m_listeners)
+      if (auto listener = weakListener.lock())
+        entries.emplace_back(listener.get(), std::move(weakListener));
+    std::sort(entries.begin(), entries.end(),
+      [](const auto& a, const auto& b) { return std::less<T_Listener*>()(a.first, b.first); });
+
+    m_listeners.clear();
+    for (auto& entry : entries)
+      m_listeners.push_back(std::move(entry.second));
   }
 
 protected:
@@ -118,10 +445,39 @@ protected:
   template <typename... Fn_Args>
   void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
   {    
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto& weakListener : m_listeners)
+        if (auto listener = weakListener.lock())
+          detail::CallMonitor::timedCall(monitor, listener.get(), fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
     for (auto& weakListener : m_listeners)
       if (auto listener = weakListener.lock())
         (listener.get()->*fn)(std::forward<Fn_Args>(args)...);
   }
+
+  //! Send all notifications \a calls to every listener before moving to the next one.
+  /*!
+    Every weak pointer is locked just once for all of the notifications.
+  */
+  template <class... T_Calls>
+  void notifyAll(const T_Calls&... calls)
+  {
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto& weakListener : m_listeners)
+        if (auto listener = weakListener.lock())
+          (calls.apply([monitor, &listener](auto fn, auto&&... args)
+            { detail::CallMonitor::timedCall(monitor, listener.get(), fn, std::forward<decltype(args)>(args)...); }), ...);
+      return;
+    }
+
+    for (auto& weakListener : m_listeners)
+      if (auto listener = weakListener.lock())
+        (calls(listener.get()), ...);
+  }
   
 private:
   std::vector<std::weak_ptr<T_Listener>> m_listeners;
@@ -130,43 +486,25 @@ private:
 
 namespace detail
 {
-//! Convenience struct for identifying if a class \a T is in pack \a Args
-/*!
-  usage: contains<T, Args...>::value
-*/
-template <typename T, typename... Args>
-struct contains 
-  : public std::disjunction<std::is_same<T, Args>...>
+//! Empty type, which represents type \a T in a TypeSet.
+template <typename T>
+struct TypeTag
 { };
 
-//! Conditionally calls attach and detach methods of the source object
+//! Set of types \a Ts, whose membership test is a single instantiation
 /*!
-  This class defines the "true" condition.
-*/
-template <bool Contains, class T_Container>
-struct cond {
-  template<class T_Source, class T_Listener>
-  static void attach(T_Source* s, const T_Listener& l) {
-    static_cast<T_Container*>(s)->attach(l);
-  }
+  The set derives from a tag of each of its types, so testing a type is one
+  is_base_of, which is resolved by the compiler's lookup of base classes,
+  instead of a comparison with every type of the set.
 
-  template<class T_Source, class T_Listener>
-  static void detach(T_Source* s, const T_Listener& l) {
-    static_cast<T_Container*>(s)->detach(l);
-  }
-};
-
-//! Conditionally calls attach and detach methods of the source object
-/*!
-  This is an empty specialization for "false" condition.
+  usage: TypeSet<Ts...>::contains<T>
 */
-template<class T_Container>
-struct cond<false, T_Container> {
-  template<class T_Source, class T_Listener>
-  static void attach(T_Source*, T_Listener) {}
-
-  template<class T_Source, class T_Listener>
-  static void detach(T_Source*, T_Listener) {}
+template <typename... Ts>
+struct TypeSet
+  : public TypeTag<Ts>...
+{
+  template <typename T>
+  static constexpr bool contains = std::is_base_of<TypeTag<T>, TypeSet>::value;
 };
 }
 
@@ -178,9 +516,12 @@ struct cond<false, T_Container> {
   are stored in separate containers, however, the user may specify the
   type of the container in \a T_Container template parameter.
   
-  Containers must have attach(), detach(), and notify methods. Currently,
-  two containers are provided: RawContainer for holding raw pointers 
-  and SmartContainer for holding weak pointers of listener objects.
+  Containers must have attach(), detach(), and notify methods. Methods
+  memoryUsage(), shrink() and compact() are needed only if used on the source,
+  forEachListener() only if notifyAsync() is used. Two basic
+  containers are provided here: RawContainer for holding raw pointers 
+  and SmartContainer for holding weak pointers of listener objects. Containers
+  with special behaviour, e.g. QueuedContainer, have their own headers.
   
   however, users may supply their own implementation.
 */
@@ -200,8 +541,7 @@ public:
   template<typename... Args>
   void attach(Listener<Args...>* listener)
   {
-    using namespace detail;
-    (cond<contains<Args, T_Listeners...>::value, T_Container<Args>>::attach(this, listener), ...);
+    (attachTo<Args>(listener), ...);
   }
 
   //! Attach a listener object, which implements listeners given by Args.
@@ -213,8 +553,7 @@ public:
   template<typename... Args>
   void attach(const std::shared_ptr<Listener<Args...>>& listener)
   {
-    using namespace detail;
-    (cond<contains<Args, T_Listeners...>::value, T_Container<Args>>::attach(this, listener), ...);
+    (attachTo<Args>(listener), ...);
   }
 
   //! Convenience method to overcome the covariant issue with smart pointers.
@@ -228,16 +567,14 @@ public:
   template<typename... Args>
   void detach(Listener<Args...>* listener)
   {
-    using namespace detail;
-    (cond<contains<Args, T_Listeners...>::value, T_Container<Args>>::detach(this, listener), ...);
+    (detachFrom<Args>(listener), ...);
   }
   
   //! Detach a listener object, which implements listeners given by Args.
   template<typename... Args>
   void detach(const std::shared_ptr<Listener<Args...>>& listener)
   {
-    using namespace detail;
-    (cond<contains<Args, T_Listeners...>::value, T_Container<Args>>::detach(this, listener), ...);
+    (detachFrom<Args>(listener), ...);
   }
   
   //! Convenience method to overcome the covariant issue with smart pointers.
@@ -247,6 +584,26 @@ public:
     detach(std::static_pointer_cast<typename T::ListenerType>(listener));
   }
 
+  //! Memory occupied by containers of all listener types.
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    ((usage += T_Container<T_Listeners>::memoryUsage()), ...);
+    return usage;
+  }
+
+  //! Release unused capacity of containers of all listener types.
+  void shrink()
+  {
+    (T_Container<T_Listeners>::shrink(), ...);
+  }
+
+  //! Sort listeners of all listener types by address, see RawContainer::compact().
+  void compact()
+  {
+    (T_Container<T_Listeners>::compact(), ...);
+  }
+
 protected:
 
   //! Call a notification function as specified by the first parameter.
@@ -260,6 +617,98 @@ protected:
     {    
       T_Container<T>::notify(fn, std::forward<Fn_Args>(args)...);
     }
+
+  //! Send several notifications, which are created by Observer::call().
+  /*!
+    All notifications must be methods of the same listener type. Containers with
+    notifyAll() send all of them to one listener before moving to the next one,
+    e.g. SmartContainer locks every listener once instead of once per notification.
+    Other containers send the notifications one after another.
+
+    usage: notifyAll(call(&Mouse::down, x, y), call(&Mouse::up, x, y))
+  */
+  template <class T_Call, class... T_Calls>
+  void notifyAll(const T_Call& first, const T_Calls&... others)
+  {
+    using T = typename T_Call::Listener;
+    static_assert(std::conjunction<std::is_same<T, typename T_Calls::Listener>...>::value,
+      "All notifications must be methods of the same listener type");
+    notifyCalls<T>(0, first, others...);
+  }
+
+  //! Call a notification function on the worker threads of \a executor, see Executor::broadcast().
+  /*!
+    The listeners attached at the moment of the call are notified, which
+    needs a container with forEachListener(), e.g. RawContainer or RcuContainer.
+    Containers, which pass a home node with every listener, e.g. NumaContainer,
+    get their listeners delivered on their home nodes.
+    Returns a handle, which tells when all listeners have returned.
+  */
+  template <class T_Executor, typename T, typename... Fn_Args>
+  auto notifyAsync(T_Executor& executor, void (T::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    std::vector<T*> listeners;
+    std::vector<unsigned> homes;
+    T_Container<T>::forEachListener([&listeners, &homes](T* listener, auto... home)
+    {
+      listeners.push_back(listener);
+      (homes.push_back(home), ...);
+    });
+    if (homes.empty())
+      return executor.broadcast(std::move(listeners), fn, std::forward<Fn_Args>(args)...);
+    return executor.broadcast(std::move(listeners), homes, fn, std::forward<Fn_Args>(args)...);
+  }
+
+private:
+  using ListenerSet = detail::TypeSet<T_Listeners...>;
+
+  // The listener is converted to the interface before the call, so that the
+  // helpers are instantiated once per interface, not once per listener class.
+
+  //! Attach \a listener to the container of \a T if this source supports \a T.
+  template <class T>
+  void attachTo(T* listener)
+  {
+    if constexpr (ListenerSet::template contains<T>)
+      T_Container<T>::attach(listener);
+  }
+
+  //! Attach \a listener to the container of \a T if this source supports \a T.
+  template <class T>
+  void attachTo(const std::shared_ptr<T>& listener)
+  {
+    if constexpr (ListenerSet::template contains<T>)
+      T_Container<T>::attach(listener);
+  }
+
+  //! Detach \a listener from the container of \a T if this source supports \a T.
+  template <class T>
+  void detachFrom(T* listener)
+  {
+    if constexpr (ListenerSet::template contains<T>)
+      T_Container<T>::detach(listener);
+  }
+
+  //! Detach \a listener from the container of \a T if this source supports \a T.
+  template <class T>
+  void detachFrom(const std::shared_ptr<T>& listener)
+  {
+    if constexpr (ListenerSet::template contains<T>)
+      T_Container<T>::detach(listener);
+  }
+
+  template <class T, class... T_Calls>
+  auto notifyCalls(int, const T_Calls&... calls) -> decltype(this->T_Container<T>::notifyAll(calls...))
+  {
+    T_Container<T>::notifyAll(calls...);
+  }
+
+  template <class T, class... T_Calls>
+  void notifyCalls(long, const T_Calls&... calls)
+  {
+    (calls.apply([this](auto fn, auto&&... args)
+      { this->T_Container<T>::notify(fn, std::forward<decltype(args)>(args)...); }), ...);
+  }
 };
 
 //! Shortcut for a source operating on raw pointers
@@ -271,3 +720,5 @@ template <class... T_Listeners>
 using SmartSource = Source<SmartContainer, T_Listeners...>;
 
 } // namespace Observer
+
+#endif // OBSERVER_H
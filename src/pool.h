@@ -0,0 +1,440 @@
+#ifndef OBSERVER_POOL_H
+#define OBSERVER_POOL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "observer.h"
+
+namespace Observer
+{
+
+namespace detail
+{
+//! How a ListenerPool holds raw pointers.
+template <class T_Listener>
+struct RawPoolTraits
+{
+  using Pointer = T_Listener*;
+  using Argument = T_Listener*;
+
+  static T_Listener* address(T_Listener* listener) { return listener; }
+  static bool expired(T_Listener*) { return false; }
+};
+
+//! How a ListenerPool holds weak pointers.
+template <class T_Listener>
+struct SmartPoolTraits
+{
+  using Pointer = std::weak_ptr<T_Listener>;
+  using Argument = std::shared_ptr<T_Listener>;
+
+  static T_Listener* address(const std::shared_ptr<T_Listener>& listener) { return listener.get(); }
+  static bool expired(const std::weak_ptr<T_Listener>& listener) { return listener.expired(); }
+};
+}
+
+//! Global pool of listeners of one type, which are referred to by 32-bit handles.
+/*!
+  Containers, which store handles instead of pointers, occupy half of the memory
+  of raw pointers and a quarter of weak pointers on 64-bit platforms. A listener
+  attached to many containers takes one slot of the pool, which is reference
+  counted and reused when the listener is released by all containers.
+
+  The pool is not thread safe. Unlike RawContainer, whose sources are
+  independent, there is one pool per listener type shared by all containers of
+  the process, so all pool containers with the listener type, even those of
+  unrelated sources, must be used on one thread at a time.
+*/
+template <class T_Listener, template<class> class T_Traits = detail::RawPoolTraits>
+class ListenerPool
+{
+public:
+  using Handle = std::uint32_t;
+  using Pointer = typename T_Traits<T_Listener>::Pointer;
+  using Argument = typename T_Traits<T_Listener>::Argument;
+
+  //! The pool of listener type \a T_Listener.
+  static ListenerPool& instance()
+  {
+    // Intentionally leaked, containers with static storage duration may outlive it otherwise.
+    static ListenerPool* pool = new ListenerPool;
+    return *pool;
+  }
+
+  //! Take a reference to the slot of \a listener, a new slot is allocated if needed.
+  Handle acquire(const Argument& listener)
+  {
+    assert(listener);
+    auto* address = T_Traits<T_Listener>::address(listener);
+    auto it = m_handles.find(address);
+    if (it != m_handles.end())
+    {
+      // A dead listener, whose address has been reused, must not share its slot
+      // with the new one. The old slot is left to the containers, which hold it.
+      if (!T_Traits<T_Listener>::expired(m_listeners[it->second]))
+      {
+        ++m_references[it->second];
+        return it->second;
+      }
+      m_handles.erase(it);
+    }
+
+    Handle handle;
+    if (!m_free.empty())
+    {
+      handle = m_free.back();
+      m_free.pop_back();
+      m_listeners[handle] = listener;
+      m_addresses[handle] = address;
+      m_references[handle] = 1;
+    }
+    else
+    {
+      handle = static_cast<Handle>(m_listeners.size());
+      m_listeners.push_back(listener);
+      m_addresses.push_back(address);
+      m_references.push_back(1);
+    }
+    m_handles.emplace(address, handle);
+    return handle;
+  }
+
+  //! Take another reference to slot \a handle.
+  void retain(Handle handle)
+  {
+    ++m_references[handle];
+  }
+
+  //! Drop a reference to slot \a handle.
+  void release(Handle handle)
+  {
+    if (--m_references[handle] != 0)
+      return;
+    auto it = m_handles.find(m_addresses[handle]);
+    if (it != m_handles.end() && it->second == handle)
+      m_handles.erase(it);
+    m_listeners[handle] = Pointer();
+    m_addresses[handle] = nullptr;
+    m_free.push_back(handle);
+  }
+
+  //! Handle of \a listener or None if the listener has no slot.
+  Handle find(const Argument& listener) const
+  {
+    auto it = m_handles.find(T_Traits<T_Listener>::address(listener));
+    return it == m_handles.end() ? None : it->second;
+  }
+
+  //! The listener in slot \a handle.
+  const Pointer& operator[](Handle handle) const
+  {
+    return m_listeners[handle];
+  }
+
+  //! Address of the listener in slot \a handle, even if it has already been destroyed.
+  T_Listener* address(Handle handle) const
+  {
+    return m_addresses[handle];
+  }
+
+  //! Memory occupied by the pool.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_listeners, sizeof(*this));
+    usage += detail::vectorUsage(m_addresses, 0);
+    usage += detail::vectorUsage(m_references, 0);
+    usage += detail::vectorUsage(m_free, 0);
+    // Rough estimate of the hash map: one node per listener and the bucket array.
+    auto map = m_handles.size() * (sizeof(typename decltype(m_handles)::value_type) + 2 * sizeof(void*))
+      + m_handles.bucket_count() * sizeof(void*);
+    usage.bytesUsed += map;
+    usage.bytesReserved += map;
+    for (std::size_t i = 0; i < m_listeners.size(); ++i)
+      if (m_references[i])
+        ++(T_Traits<T_Listener>::expired(m_listeners[i]) ? usage.deadEntries : usage.liveEntries);
+    return usage;
+  }
+
+  static constexpr Handle None = ~Handle(0);
+
+private:
+  ListenerPool() = default;
+
+  std::vector<Pointer> m_listeners;
+  std::vector<T_Listener*> m_addresses;
+  std::vector<std::uint32_t> m_references;
+  std::vector<Handle> m_free;
+  std::unordered_map<T_Listener*, Handle> m_handles;
+};
+
+namespace detail
+{
+//! Sort \a handles of pool \a T_Pool by the address of their listeners.
+template <class T_Pool>
+void sortByAddress(std::vector<typename T_Pool::Handle>& handles)
+{
+  const auto& pool = T_Pool::instance();
+  using Address = decltype(pool.address(0));
+  std::sort(handles.begin(), handles.end(),
+    [&pool](auto a, auto b) { return std::less<Address>()(pool.address(a), pool.address(b)); });
+}
+}
+
+//! A container of listeners, which holds 32-bit handles to the global ListenerPool.
+/*!
+  This is a collection of handles of listener objects of a single type, which
+  is defined by the template parameter. Listeners are held as raw pointers in
+  the pool. The container is to be used in Source class. Containers of the same
+  listener type share the pool, so they must all be used on one thread at a
+  time, see ListenerPool.
+*/
+template <class T_Listener>
+class PoolContainer
+{
+public:
+  using Pool = ListenerPool<T_Listener>;
+
+  PoolContainer() = default;
+
+  PoolContainer(const PoolContainer& other)
+    : m_handles(other.m_handles)
+  {
+    for (auto handle : m_handles)
+      pool().retain(handle);
+  }
+
+  PoolContainer& operator=(const PoolContainer& other)
+  {
+    PoolContainer copy(other);
+    m_handles.swap(copy.m_handles);
+    return *this;
+  }
+
+  virtual ~PoolContainer()
+  {
+    for (auto handle : m_handles)
+      pool().release(handle);
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    m_handles.push_back(pool().acquire(listener));
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    auto handle = pool().find(listener);
+    if (handle == Pool::None)
+      return;
+    auto end = std::remove(m_handles.begin(), m_handles.end(), handle);
+    for (auto it = end; it != m_handles.end(); ++it)
+      pool().release(handle);
+    m_handles.erase(end, m_handles.end());
+  }
+
+  //! Memory occupied by this container, the pool is not included.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_handles, sizeof(*this));
+    usage.liveEntries = m_handles.size();
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    m_handles.shrink_to_fit();
+  }
+
+  //! Sort handles by the address of their listeners, see RawContainer::compact().
+  void compact()
+  {
+    detail::sortByAddress<Pool>(m_handles);
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    const auto& listeners = pool();
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto handle : m_handles)
+        detail::CallMonitor::timedCall(monitor, listeners[handle], fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto handle : m_handles)
+      (listeners[handle]->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+private:
+  static Pool& pool()
+  {
+    return Pool::instance();
+  }
+
+  std::vector<typename Pool::Handle> m_handles;
+};
+
+//! A container of listeners, which holds 32-bit handles to a global pool of weak pointers.
+/*!
+  Like SmartContainer, listeners are held as weak pointers, but the weak pointers
+  are stored in the pool once per listener and the container holds just handles.
+  Containers of the same listener type share the pool, so they must all be used
+  on one thread at a time, see ListenerPool.
+*/
+template <class T_Listener>
+class SmartPoolContainer
+{
+public:
+  using Pool = ListenerPool<T_Listener, detail::SmartPoolTraits>;
+
+  SmartPoolContainer() = default;
+
+  SmartPoolContainer(const SmartPoolContainer& other)
+    : m_handles(other.m_handles)
+  {
+    for (auto handle : m_handles)
+      pool().retain(handle);
+  }
+
+  SmartPoolContainer& operator=(const SmartPoolContainer& other)
+  {
+    SmartPoolContainer copy(other);
+    m_handles.swap(copy.m_handles);
+    return *this;
+  }
+
+  virtual ~SmartPoolContainer()
+  {
+    for (auto handle : m_handles)
+      pool().release(handle);
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+    Note that a weak pointer to the listener is actually stored in the pool.
+  */
+  void attach(const std::shared_ptr<T_Listener>& listener)
+  {
+    m_handles.push_back(pool().acquire(listener));
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+    Handles of listeners, which have already expired, are erased as well.
+  */
+  void detach(const std::shared_ptr<T_Listener>& listener)
+  {
+    auto handle = pool().find(listener);
+    eraseIf([handle](auto h) { return h == handle || pool()[h].expired(); });
+  }
+
+  //! Memory occupied by this container, the pool is not included.
+  /*!
+    Handles of listeners, which have already been destroyed, are reported as dead.
+  */
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_handles, sizeof(*this));
+    for (auto handle : m_handles)
+      ++(pool()[handle].expired() ? usage.deadEntries : usage.liveEntries);
+    return usage;
+  }
+
+  //! Erase handles of destroyed listeners and release unused capacity.
+  void shrink()
+  {
+    eraseIf([](auto h) { return pool()[h].expired(); });
+    m_handles.shrink_to_fit();
+  }
+
+  //! Erase handles of destroyed listeners and sort the others by address.
+  /*!
+    This changes the order of notifications, see RawContainer::compact().
+  */
+  void compact()
+  {
+    eraseIf([](auto h) { return pool()[h].expired(); });
+    detail::sortByAddress<Pool>(m_handles);
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    const auto& listeners = pool();
+    auto* monitor = detail::CallMonitor::sample();
+    for (auto handle : m_handles)
+      if (auto listener = listeners[handle].lock())
+      {
+        if (monitor)
+          detail::CallMonitor::timedCall(monitor, listener.get(), fn, std::forward<Fn_Args>(args)...);
+        else
+          (listener.get()->*fn)(std::forward<Fn_Args>(args)...);
+      }
+  }
+
+private:
+  static Pool& pool()
+  {
+    return Pool::instance();
+  }
+
+  //! Erase handles satisfying \a condition and release their slots.
+  /*!
+    The handles are partitioned rather than removed, since std::remove_if
+    leaves unspecified values behind the new end, which must not be released.
+  */
+  template <class F>
+  void eraseIf(F&& condition)
+  {
+    auto end = std::stable_partition(m_handles.begin(), m_handles.end(),
+      [&condition](auto h) { return !condition(h); });
+    for (auto it = end; it != m_handles.end(); ++it)
+      pool().release(*it);
+    m_handles.erase(end, m_handles.end());
+  }
+
+  std::vector<typename Pool::Handle> m_handles;
+};
+
+//! Shortcut for a source operating on handles of raw pointers
+template <class... T_Listeners>
+using PoolSource = Source<PoolContainer, T_Listeners...>;
+
+//! Shortcut for a source operating on handles of weak pointers
+template <class... T_Listeners>
+using SmartPoolSource = Source<SmartPoolContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_POOL_H
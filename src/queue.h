@@ -0,0 +1,91 @@
+#ifndef OBSERVER_QUEUE_H
+#define OBSERVER_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Observer
+{
+
+namespace detail
+{
+//! Unbounded lock-free queue for multiple producers and a single consumer.
+/*!
+  This is the intrusive node based queue by Dmitry Vyukov. Pushing is a single
+  atomic exchange, so producers never wait for each other or for the consumer.
+  Only one thread at a time may call pop().
+
+  A pop() may fail although a push() has already started on another thread,
+  until the producer links its node. Such an element is returned by a later pop().
+*/
+template <class T>
+class MpscQueue
+{
+public:
+  MpscQueue()
+    : m_head(new Node)
+    , m_tail(m_head.load(std::memory_order_relaxed))
+  {}
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  ~MpscQueue()
+  {
+    while (m_tail)
+    {
+      Node* next = m_tail->next.load(std::memory_order_relaxed);
+      delete m_tail;
+      m_tail = next;
+    }
+  }
+
+  //! Append \a value to the queue. May be called from any thread.
+  void push(T value)
+  {
+    Node* node = new Node;
+    node->value = std::move(value);
+    Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  //! Move the oldest element to \a value. Returns false if the queue is empty.
+  bool pop(T& value)
+  {
+    Node* next = m_tail->next.load(std::memory_order_acquire);
+    if (!next)
+      return false;
+    value = std::move(next->value);
+    next->value = T();
+    delete m_tail;
+    m_tail = next;
+    return true;
+  }
+
+  //! Returns true if there is no element, which is ready to be popped.
+  /*!
+    Only the consumer thread may call this method.
+  */
+  bool empty() const
+  {
+    return m_tail->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  struct Node
+  {
+    std::atomic<Node*> next{nullptr};
+    T value{};
+  };
+
+  // Producers append at the head, the consumer takes from the tail.
+  // The tail node is a dummy, whose value has already been consumed.
+  alignas(64) std::atomic<Node*> m_head;
+  alignas(64) Node* m_tail;
+};
+}
+
+} // namespace Observer
+
+#endif // OBSERVER_QUEUE_H
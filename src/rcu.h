@@ -0,0 +1,205 @@
+#ifndef OBSERVER_RCU_H
+#define OBSERVER_RCU_H
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+#include "epoch.h"
+#include "observer.h"
+
+namespace Observer
+{
+
+//! A container of listeners, which may be notified from several threads at once.
+/*!
+  Listeners are kept in an immutable array. attach() and detach() copy the
+  array, publish the copy and retire the old array to the global() domain of
+  \a T_Domain, so they are serialized by a mutex and cost a copy of all
+  listeners. Notifications take no lock, a notification only protects the
+  current array by a guard of the domain and walks it. The domain is either
+  EpochDomain, see RcuContainer, or HazardDomain, see HazardContainer.
+
+  A listener detached by another thread may still receive a notification,
+  which started before detach() returned. The container itself must not be
+  destroyed while it is being notified.
+
+  Behaves like RawContainer otherwise, so listeners are held as raw pointers.
+*/
+template <class T_Listener, class T_Domain>
+class CopyOnWriteContainer
+{
+  using Listeners = std::vector<T_Listener*>;
+
+public:
+  CopyOnWriteContainer() = default;
+
+  CopyOnWriteContainer(const CopyOnWriteContainer& other)
+    : m_listeners(other.copy())
+  {}
+
+  CopyOnWriteContainer& operator=(const CopyOnWriteContainer& other)
+  {
+    if (this != &other)
+    {
+      Listeners* listeners = other.copy();
+      std::lock_guard<std::mutex> lock(m_mutex);
+      publish(listeners);
+    }
+    return *this;
+  }
+
+  virtual ~CopyOnWriteContainer()
+  {
+    delete m_listeners.load(std::memory_order_relaxed);
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    assert(listener);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Listeners* current = m_listeners.load(std::memory_order_relaxed);
+    Listeners* listeners = new Listeners;
+    listeners->reserve((current ? current->size() : 0) + 1);
+    if (current)
+      listeners->assign(current->begin(), current->end());
+    listeners->push_back(listener);
+    publish(listeners);
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Listeners* current = m_listeners.load(std::memory_order_relaxed);
+    if (!current || std::find(current->begin(), current->end(), listener) == current->end())
+      return;
+
+    Listeners* listeners = nullptr;
+    auto count = current->size() - std::count(current->begin(), current->end(), listener);
+    if (count)
+    {
+      listeners = new Listeners;
+      listeners->reserve(count);
+      std::remove_copy(current->begin(), current->end(), std::back_inserter(*listeners), listener);
+    }
+    publish(listeners);
+  }
+
+  //! Memory occupied by this container.
+  /*!
+    Arrays retired but not yet deleted are accounted by the domain, see EpochDomain::pendingBytes().
+  */
+  MemoryUsage memoryUsage() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Listeners* current = m_listeners.load(std::memory_order_relaxed);
+    if (!current)
+    {
+      MemoryUsage usage;
+      usage.bytesUsed = usage.bytesReserved = sizeof(*this);
+      return usage;
+    }
+    auto usage = detail::vectorUsage(*current, sizeof(*this) + sizeof(Listeners));
+    usage.liveEntries = current->size();
+    return usage;
+  }
+
+  //! Sort listeners by their address, see RawContainer::compact().
+  void compact()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Listeners* listeners = copyLocked();
+    if (listeners)
+      std::sort(listeners->begin(), listeners->end(), std::less<T_Listener*>());
+    publish(listeners);
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    typename T_Domain::Guard guard;
+    const Listeners* listeners = guard.protect(m_listeners);
+    if (!listeners)
+      return;
+
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* l : *listeners)
+        detail::CallMonitor::timedCall(monitor, l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto* l : *listeners)
+      (l->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+  //! Call \a function for every listener, see Source::notifyAsync().
+  template <class F>
+  void forEachListener(F&& function) const
+  {
+    typename T_Domain::Guard guard;
+    if (const Listeners* listeners = guard.protect(m_listeners))
+    {
+      for (auto* l : *listeners)
+        function(l);
+    }
+  }
+
+private:
+  Listeners* copy() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return copyLocked();
+  }
+
+  Listeners* copyLocked() const
+  {
+    const Listeners* current = m_listeners.load(std::memory_order_relaxed);
+    return current ? new Listeners(*current) : nullptr;
+  }
+
+  //! Replace the array by \a listeners, the caller holds the mutex.
+  void publish(Listeners* listeners)
+  {
+    Listeners* old = m_listeners.exchange(listeners, std::memory_order_acq_rel);
+    if (old)
+      T_Domain::global().retire(old, sizeof(Listeners) + old->capacity() * sizeof(T_Listener*));
+  }
+
+  // Null while there are no listeners, so that an empty container allocates nothing.
+  std::atomic<Listeners*> m_listeners{nullptr};
+  mutable std::mutex m_mutex;
+};
+
+//! A container of listeners, which may be notified from several threads at once, see CopyOnWriteContainer.
+/*!
+  Notifications enter a critical section of EpochDomain, which costs only a
+  couple of relaxed operations.
+*/
+template <class T_Listener>
+using RcuContainer = CopyOnWriteContainer<T_Listener, EpochDomain>;
+
+//! Shortcut for a source, whose listener arrays are reclaimed by epochs
+template <class... T_Listeners>
+using RcuSource = Source<RcuContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_RCU_H
@@ -0,0 +1,213 @@
+#ifndef OBSERVER_RECLAIM_H
+#define OBSERVER_RECLAIM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/membarrier.h>)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+#if defined(__NR_membarrier)
+#define OBSERVER_MEMBARRIER 1
+#else
+#define OBSERVER_MEMBARRIER 0
+#endif
+
+namespace Observer
+{
+
+namespace detail
+{
+//! A pair of fences of readers and reclaimers of shared memory.
+/*!
+  Readers publish what they are about to read and must make it visible before
+  they read. Reclaimers must see it before they delete anything. On Linux with
+  membarrier the reader fence is only a compiler barrier and the reclaimer
+  interrupts all threads of the process instead, which is cheap when readers
+  are many and reclaimers are rare. Otherwise both issue a full fence.
+*/
+class AsymmetricFence
+{
+public:
+  AsymmetricFence()
+  {
+#if OBSERVER_MEMBARRIER
+    m_enabled = syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#endif
+  }
+
+  //! True if the reader fence is a compiler barrier only.
+  bool enabled() const
+  {
+    return m_enabled;
+  }
+
+  //! Fence of a reader between publishing and reading.
+  void light() const
+  {
+    if (m_enabled)
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    else
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  //! Fence of a reclaimer before it inspects what readers have published.
+  void heavy() const
+  {
+#if OBSERVER_MEMBARRIER
+    if (m_enabled)
+    {
+      [[maybe_unused]] long result = syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+      assert(result == 0);
+      return;
+    }
+#endif
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+private:
+  bool m_enabled = false;
+};
+
+//! Base of a record of one thread in a reclamation domain.
+/*!
+  Records are never unlinked. A record of a finished thread is reused by
+  a new thread or claimed for a while by another thread, which reclaims
+  objects left behind in it.
+*/
+struct alignas(64) ThreadRecord
+{
+  std::atomic<bool> used{true};
+  ThreadRecord* next = nullptr;
+
+  //! Claim a record, which is not used by any thread.
+  bool tryAcquire()
+  {
+    bool expected = false;
+    return !used.load(std::memory_order_relaxed)
+      && used.compare_exchange_strong(expected, true, std::memory_order_acquire);
+  }
+
+  void release()
+  {
+    used.store(false, std::memory_order_release);
+  }
+};
+
+//! Records of the calling thread in all domains, which are released when the thread finishes.
+struct ThreadRegistration
+{
+  ~ThreadRegistration()
+  {
+    for (auto& entry : entries)
+      entry.second->release();
+  }
+
+  static ThreadRegistration& local()
+  {
+    static thread_local ThreadRegistration registration;
+    return registration;
+  }
+
+  std::vector<std::pair<const void*, ThreadRecord*>> entries;
+};
+
+//! Lock-free list of records of type \a T_Record, one per thread, which is derived from ThreadRecord.
+/*!
+  The list must outlive all threads, which have a record in it, except the one
+  destroying it.
+*/
+template <class T_Record>
+class ThreadRecords
+{
+public:
+  ThreadRecords() = default;
+  ThreadRecords(const ThreadRecords&) = delete;
+  ThreadRecords& operator=(const ThreadRecords&) = delete;
+
+  ~ThreadRecords()
+  {
+    auto& entries = ThreadRegistration::local().entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+      [this](const auto& entry) { return entry.first == this; }), entries.end());
+    if (t_owner == this)
+      t_owner = nullptr;
+
+    ThreadRecord* record = m_head.load(std::memory_order_acquire);
+    while (record)
+    {
+      ThreadRecord* next = record->next;
+      delete static_cast<T_Record*>(record);
+      record = next;
+    }
+  }
+
+  //! The record of the calling thread, the common case is one list used by a thread.
+  T_Record& local()
+  {
+    if (t_owner == this)
+      return *t_record;
+    return attachThread();
+  }
+
+  //! Call \a function for every record.
+  template <class F>
+  void forEach(F&& function) const
+  {
+    for (ThreadRecord* record = m_head.load(std::memory_order_acquire); record; record = record->next)
+      function(*static_cast<T_Record*>(record));
+  }
+
+private:
+  T_Record& attachThread()
+  {
+    auto& entries = ThreadRegistration::local().entries;
+    T_Record* record = nullptr;
+    for (auto& entry : entries)
+    {
+      if (entry.first == this)
+        record = static_cast<T_Record*>(entry.second);
+    }
+
+    if (!record)
+    {
+      for (ThreadRecord* r = m_head.load(std::memory_order_acquire); r && !record; r = r->next)
+      {
+        if (r->tryAcquire())
+          record = static_cast<T_Record*>(r);
+      }
+      if (!record)
+      {
+        record = new T_Record;
+        ThreadRecord* head = m_head.load(std::memory_order_relaxed);
+        do
+        {
+          record->next = head;
+        } while (!m_head.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+      }
+      entries.emplace_back(this, record);
+    }
+
+    t_owner = this;
+    t_record = record;
+    return *record;
+  }
+
+  std::atomic<ThreadRecord*> m_head{nullptr};
+
+  static inline thread_local const ThreadRecords* t_owner = nullptr;
+  static inline thread_local T_Record* t_record = nullptr;
+};
+}
+
+} // namespace Observer
+
+#endif // OBSERVER_RECLAIM_H
@@ -0,0 +1,297 @@
+#ifndef OBSERVER_REGISTRY_H
+#define OBSERVER_REGISTRY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "observer.h"
+
+namespace Observer
+{
+
+//! Global table of all subscriptions to listeners of type \a T_Listener.
+/*!
+  Subscriptions of all sources are densely packed in one array. Subscriptions of
+  one source are linked into a chain, whose head is found through a sparse array
+  indexed by the source id. Detaching moves the last subscription into the freed
+  slot, so the array never has holes and notifyAll() walks it linearly.
+
+  The registry is not thread safe. Unlike RawContainer, whose sources are
+  independent, there is one registry per listener type shared by all sources
+  of the process, so all sources with the listener type, even unrelated ones,
+  must be created, changed, notified and destroyed on one thread at a time.
+*/
+template <class T_Listener>
+class Registry
+{
+public:
+  //! The registry of listener type \a T_Listener.
+  static Registry& instance()
+  {
+    // Intentionally leaked, sources with static storage duration may outlive it otherwise.
+    static Registry* registry = new Registry;
+    return *registry;
+  }
+
+  //! Allocate an id for a new source.
+  std::uint32_t create()
+  {
+    if (!m_freeIds.empty())
+    {
+      auto id = m_freeIds.back();
+      m_freeIds.pop_back();
+      return id;
+    }
+    m_heads.push_back(None);
+    return static_cast<std::uint32_t>(m_heads.size() - 1);
+  }
+
+  //! Remove all subscriptions of source \a id and release the id.
+  void destroy(std::uint32_t id)
+  {
+    while (m_heads[id] != None)
+      erase(id, None, m_heads[id]);
+    m_freeIds.push_back(id);
+  }
+
+  //! Subscribe \a listener to notifications of source \a id.
+  void attach(std::uint32_t id, T_Listener* listener)
+  {
+    assert(listener);
+    auto index = static_cast<std::uint32_t>(m_entries.size());
+    m_entries.push_back({ listener, id, None });
+
+    // Append to the end of the chain to keep the order of attachment.
+    auto* link = &m_heads[id];
+    while (*link != None)
+      link = &m_entries[*link].next;
+    *link = index;
+  }
+
+  //! Unsubscribe \a listener from notifications of source \a id.
+  void detach(std::uint32_t id, T_Listener* listener)
+  {
+    // Erasing moves entries around, so the chain is searched from the head again.
+    for (bool found = true; found;)
+    {
+      found = false;
+      auto previous = None;
+      for (auto index = m_heads[id]; index != None; previous = index, index = m_entries[index].next)
+        if (m_entries[index].listener == listener)
+        {
+          erase(id, previous, index);
+          found = true;
+          break;
+        }
+    }
+  }
+
+  //! Notify listeners of source \a id.
+  template <typename... Fn_Args>
+  void notify(std::uint32_t id, void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto index = m_heads[id]; index != None; index = m_entries[index].next)
+        detail::CallMonitor::timedCall(monitor, m_entries[index].listener, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto index = m_heads[id]; index != None; index = m_entries[index].next)
+      (m_entries[index].listener->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+  //! Notify listeners of all sources in one linear sweep.
+  /*!
+    The order of calls is the order of subscriptions in the table, which is
+    unrelated to the order of sources.
+  */
+  template <typename... Fn_Args>
+  void notifyAll(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto& entry : m_entries)
+        detail::CallMonitor::timedCall(monitor, entry.listener, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    for (auto& entry : m_entries)
+      (entry.listener->*fn)(std::forward<Fn_Args>(args)...);
+  }
+
+  //! Number of subscriptions of source \a id.
+  std::size_t count(std::uint32_t id) const
+  {
+    std::size_t result = 0;
+    for (auto index = m_heads[id]; index != None; index = m_entries[index].next)
+      ++result;
+    return result;
+  }
+
+  //! Number of subscriptions of all sources.
+  std::size_t size() const
+  {
+    return m_entries.size();
+  }
+
+  //! Memory occupied by the tables of the registry.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = detail::vectorUsage(m_entries, sizeof(*this));
+    usage += detail::vectorUsage(m_heads, 0);
+    usage += detail::vectorUsage(m_freeIds, 0);
+    usage.liveEntries = m_entries.size();
+    return usage;
+  }
+
+  //! Release unused capacity of the tables.
+  void shrink()
+  {
+    m_entries.shrink_to_fit();
+    m_heads.shrink_to_fit();
+    m_freeIds.shrink_to_fit();
+  }
+
+  //! Size of a subscription in the dense table.
+  static constexpr std::size_t EntrySize = 2 * sizeof(std::uint32_t) + sizeof(T_Listener*);
+
+  //! Size of the sparse slot of one source.
+  static constexpr std::size_t SlotSize = sizeof(std::uint32_t);
+
+private:
+  static constexpr std::uint32_t None = ~std::uint32_t(0);
+
+  struct Entry
+  {
+    T_Listener* listener;
+    std::uint32_t source;
+    std::uint32_t next;
+  };
+
+  Registry() = default;
+
+  //! Erase entry \a index of source \a id, whose predecessor in the chain is \a previous.
+  void erase(std::uint32_t id, std::uint32_t previous, std::uint32_t index)
+  {
+    (previous == None ? m_heads[id] : m_entries[previous].next) = m_entries[index].next;
+
+    auto last = static_cast<std::uint32_t>(m_entries.size() - 1);
+    if (index != last)
+    {
+      // Move the last entry into the hole and redirect the link pointing to it.
+      m_entries[index] = m_entries[last];
+      auto* link = &m_heads[m_entries[index].source];
+      while (*link != last)
+        link = &m_entries[*link].next;
+      *link = index;
+    }
+    m_entries.pop_back();
+  }
+
+  std::vector<Entry> m_entries;
+  std::vector<std::uint32_t> m_heads;
+  std::vector<std::uint32_t> m_freeIds;
+};
+
+//! A container of listeners, which keeps its subscriptions in the global Registry.
+/*!
+  The container itself holds only the id of the source, all subscriptions live
+  in the Registry of the listener type. This suits worlds of millions of sources
+  with few listeners each, where a separate vector in every source would waste
+  memory and scatter data, and it allows to notify all sources in one linear
+  sweep by Registry::notifyAll().
+
+  Deliberately has no virtual destructor, so that the per-source footprint is
+  just the id. The container cannot be copied. Listeners are held as raw pointers.
+  The container is not thread safe and, as the registry is shared, neither are
+  two containers of the same listener type used on different threads, see Registry.
+*/
+template <class T_Listener>
+class RegistryContainer
+{
+public:
+  RegistryContainer()
+    : m_id(registry().create())
+  {}
+
+  RegistryContainer(const RegistryContainer&) = delete;
+  RegistryContainer& operator=(const RegistryContainer&) = delete;
+
+  ~RegistryContainer()
+  {
+    registry().destroy(m_id);
+  }
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    registry().attach(m_id, listener);
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+    registry().detach(m_id, listener);
+  }
+
+  //! Memory occupied by this container and its share of the registry.
+  /*!
+    Unused capacity of the registry tables is not included, see Registry::memoryUsage().
+  */
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    usage.liveEntries = registry().count(m_id);
+    usage.bytesUsed = sizeof(*this) + Registry<T_Listener>::SlotSize
+      + usage.liveEntries * Registry<T_Listener>::EntrySize;
+    usage.bytesReserved = usage.bytesUsed;
+    return usage;
+  }
+
+  //! Does nothing, the capacity is managed by the registry, see Registry::shrink().
+  void shrink()
+  {
+  }
+
+  //! Id of this container in the registry.
+  std::uint32_t id() const
+  {
+    return m_id;
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+    registry().notify(m_id, fn, std::forward<Fn_Args>(args)...);
+  }
+
+private:
+  static Registry<T_Listener>& registry()
+  {
+    return Registry<T_Listener>::instance();
+  }
+
+  std::uint32_t m_id;
+};
+
+//! Shortcut for a source, which keeps its subscriptions in the global registries
+template <class... T_Listeners>
+using RegistrySource = Source<RegistryContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_REGISTRY_H
@@ -0,0 +1,250 @@
+#ifndef OBSERVER_RESOLVED_H
+#define OBSERVER_RESOLVED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "observer.h"
+
+//! Whether the call target of a pointer to member function can be resolved.
+/*!
+  Resolution decodes pointers to member functions of the Itanium C++ ABI, which
+  is used by GCC and Clang except on Windows. Elsewhere ResolvedContainer calls
+  through the pointers to member functions like RawContainer.
+*/
+#if !defined(OBSERVER_RESOLVED_CALLS)
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+#define OBSERVER_RESOLVED_CALLS 1
+#else
+#define OBSERVER_RESOLVED_CALLS 0
+#endif
+#endif
+
+namespace Observer
+{
+
+namespace detail
+{
+//! Target of a call of a member function on a particular object.
+struct ResolvedCall
+{
+  //! Object with the this-adjustment applied.
+  void* object;
+  //! Address of the final overrider, to be called with \a object as the first argument.
+  void (*function)();
+};
+
+#if OBSERVER_RESOLVED_CALLS
+//! Pointer to member function of the Itanium C++ ABI.
+/*!
+  It is a pair of a pointer and an adjustment of this. The pointer is either the
+  address of the function or, for virtual functions, the offset into the virtual
+  table plus one. ARM and MIPS mark virtual functions by the lowest bit of the
+  doubled adjustment instead.
+*/
+struct MemberFunction
+{
+  std::uintptr_t pointer;
+  std::ptrdiff_t adjustment;
+
+  template <class T_Listener, typename... Fn_Args>
+  explicit MemberFunction(void (T_Listener::*fn)(Fn_Args...))
+  {
+    static_assert(sizeof(fn) == sizeof(MemberFunction), "unexpected pointer to member function");
+    std::memcpy(this, &fn, sizeof(fn));
+  }
+};
+
+//! Resolve the call of member function \a representation on \a listener as a virtual call would.
+inline ResolvedCall resolve(void* listener, const MemberFunction& representation)
+{
+#if defined(__arm__) || defined(__aarch64__) || defined(__mips__)
+  bool isVirtual = representation.adjustment & 1;
+  auto adjustment = representation.adjustment >> 1;
+  auto offset = representation.pointer;
+#else
+  bool isVirtual = representation.pointer & 1;
+  auto adjustment = representation.adjustment;
+  auto offset = representation.pointer - 1;
+#endif
+
+  ResolvedCall call;
+  call.object = static_cast<char*>(listener) + adjustment;
+  if (isVirtual)
+  {
+    const char* table;
+    std::memcpy(&table, call.object, sizeof(table));
+    std::memcpy(&call.function, table + offset, sizeof(call.function));
+  }
+  else
+  {
+    std::memcpy(&call.function, &representation.pointer, sizeof(call.function));
+  }
+  return call;
+}
+#endif
+}
+
+//! A container of listeners, which resolves the call targets of notifications in advance.
+/*!
+  A call through a pointer to member function tests whether the function is
+  virtual, adjusts this and loads the virtual table of the listener. The container
+  does the work once for every listener and notification method and keeps the
+  results in a dense array per method, which is then walked by notifications with
+  one indirect call per listener.
+
+  The array of a method is built by the first notification of the method and it
+  is updated by every attach and detach, so the container suits sources, which
+  notify a lot more often than their listeners change. Behaves like RawContainer
+  otherwise, so listeners are held as raw pointers.
+*/
+template <class T_Listener>
+class ResolvedContainer : public RawContainer<T_Listener>
+{
+public:
+
+  //! Attach listener \a listener to this container.
+  /*!
+    When attached, notifications are sent to the listener.
+  */
+  void attach(T_Listener* listener)
+  {
+    RawContainer<T_Listener>::attach(listener);
+#if OBSERVER_RESOLVED_CALLS
+    for (auto& table : m_tables)
+      table.calls.push_back(detail::resolve(listener, table.fn));
+#endif
+  }
+
+  //! Detach listener \a listener from this container.
+  /*!
+    When detached, notifications aren't sent to the listener anymore.
+  */
+  void detach(T_Listener* listener)
+  {
+#if OBSERVER_RESOLVED_CALLS
+    // Entries of the arrays follow the order of listeners.
+    const auto& listeners = this->listeners();
+    for (auto& table : m_tables)
+    {
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < listeners.size(); ++i)
+        if (listeners[i] != listener)
+          table.calls[kept++] = table.calls[i];
+      table.calls.resize(kept);
+    }
+#endif
+    RawContainer<T_Listener>::detach(listener);
+  }
+
+  //! Memory occupied by this container including the resolved calls.
+  MemoryUsage memoryUsage() const
+  {
+    auto usage = RawContainer<T_Listener>::memoryUsage();
+#if OBSERVER_RESOLVED_CALLS
+    usage += detail::vectorUsage(m_tables, 0);
+    for (const auto& table : m_tables)
+      usage += detail::vectorUsage(table.calls, 0);
+#endif
+    return usage;
+  }
+
+  //! Release unused capacity.
+  void shrink()
+  {
+    RawContainer<T_Listener>::shrink();
+#if OBSERVER_RESOLVED_CALLS
+    m_tables.shrink_to_fit();
+    for (auto& table : m_tables)
+      table.calls.shrink_to_fit();
+#endif
+  }
+
+  //! Sort listeners and their resolved calls by address, see RawContainer::compact().
+  void compact()
+  {
+    RawContainer<T_Listener>::compact();
+#if OBSERVER_RESOLVED_CALLS
+    for (auto& table : m_tables)
+    {
+      table.calls.clear();
+      for (auto* l : this->listeners())
+        table.calls.push_back(detail::resolve(l, table.fn));
+    }
+#endif
+  }
+
+protected:
+
+  //! Call a notification function as specified by the first parameter.
+  /*!
+    All listeners registered in this container are notified.
+    The parameter pack is forwarded to that function.
+  */
+  template <typename... Fn_Args>
+  void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+  {
+#if OBSERVER_RESOLVED_CALLS
+    if (auto* monitor = detail::CallMonitor::sample())
+    {
+      for (auto* l : this->listeners())
+        detail::CallMonitor::timedCall(monitor, l, fn, std::forward<Fn_Args>(args)...);
+      return;
+    }
+
+    // A listener may notify another method, whose table is then built and may
+    // reallocate the tables, so the table is looked up by index on every call.
+    using Function = void (*)(void*, Fn_Args...);
+    const auto index = tableIndex(fn);
+    for (std::size_t i = 0; i < m_tables[index].calls.size(); ++i)
+    {
+      auto call = m_tables[index].calls[i];
+      reinterpret_cast<Function>(call.function)(call.object, std::forward<Fn_Args>(args)...);
+    }
+#else
+    RawContainer<T_Listener>::notify(fn, std::forward<Fn_Args>(args)...);
+#endif
+  }
+
+private:
+#if OBSERVER_RESOLVED_CALLS
+  //! Resolved calls of one notification method.
+  struct Table
+  {
+    MethodId method;
+    detail::MemberFunction fn;
+    std::vector<detail::ResolvedCall> calls;
+  };
+
+  //! Index of the table of method \a fn, which is built if it does not exist yet.
+  template <typename... Fn_Args>
+  std::size_t tableIndex(void (T_Listener::*fn)(Fn_Args...))
+  {
+    MethodId method(fn);
+    if (m_last < m_tables.size() && m_tables[m_last].method == method)
+      return m_last;
+    for (m_last = 0; m_last < m_tables.size(); ++m_last)
+      if (m_tables[m_last].method == method)
+        return m_last;
+
+    Table table{ method, detail::MemberFunction(fn), {} };
+    for (auto* l : this->listeners())
+      table.calls.push_back(detail::resolve(l, table.fn));
+    m_tables.push_back(std::move(table));
+    return m_last;
+  }
+
+  std::vector<Table> m_tables;
+  std::size_t m_last = 0;
+#endif
+};
+
+//! Shortcut for a source, which resolves call targets of notifications in advance
+template <class... T_Listeners>
+using ResolvedSource = Source<ResolvedContainer, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_RESOLVED_H
@@ -0,0 +1,240 @@
+#ifndef OBSERVER_SEQLOCK_H
+#define OBSERVER_SEQLOCK_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "observer.h"
+
+namespace Observer
+{
+
+//! Containers of at most \a T_Capacity listeners guarded by a sequence lock.
+template <std::size_t T_Capacity>
+struct Seqlocked
+{
+  static_assert(T_Capacity > 0, "Capacity must be positive");
+
+  //! A container of a few listeners, which may be notified from several threads at once.
+  /*!
+    Listeners are kept in an array inside the container, next to a sequence
+    number, which is odd while a writer changes the array. A notification
+    copies the array to the stack and checks that the sequence number has not
+    changed meanwhile, otherwise it copies the array again. So notifications
+    write no shared memory at all and do not even follow a pointer, unlike
+    RcuContainer. Writers spin on each other and make readers retry, so the
+    container is meant for listeners, which change rarely.
+
+    attach() throws std::length_error if the container is full.
+
+    A listener detached by another thread may still receive a notification,
+    which started before detach() returned.
+  */
+  template <class T_Listener>
+  class Container
+  {
+  public:
+    //! Maximal number of listeners.
+    static constexpr std::size_t Capacity = T_Capacity;
+
+    Container() = default;
+
+    Container(const Container& other)
+    {
+      Snapshot snapshot = other.read();
+      for (std::size_t i = 0; i < snapshot.count; ++i)
+        m_listeners[i].store(snapshot.listeners[i], std::memory_order_relaxed);
+      m_count.store(snapshot.count, std::memory_order_relaxed);
+    }
+
+    Container& operator=(const Container& other)
+    {
+      if (this != &other)
+      {
+        Snapshot snapshot = other.read();
+        Writer writer(*this);
+        for (std::size_t i = 0; i < snapshot.count; ++i)
+          m_listeners[i].store(snapshot.listeners[i], std::memory_order_relaxed);
+        m_count.store(snapshot.count, std::memory_order_relaxed);
+      }
+      return *this;
+    }
+
+    virtual ~Container() {}
+
+    //! Attach listener \a listener to this container.
+    /*!
+      When attached, notifications are sent to the listener.
+    */
+    void attach(T_Listener* listener)
+    {
+      assert(listener);
+      Writer writer(*this);
+      std::size_t count = m_count.load(std::memory_order_relaxed);
+      if (count == Capacity)
+        throw std::length_error("Observer::Seqlocked<>::Container is full");
+      m_listeners[count].store(listener, std::memory_order_relaxed);
+      m_count.store(count + 1, std::memory_order_relaxed);
+    }
+
+    //! Detach listener \a listener from this container.
+    /*!
+      When detached, notifications aren't sent to the listener anymore.
+    */
+    void detach(T_Listener* listener)
+    {
+      Writer writer(*this);
+      std::size_t count = m_count.load(std::memory_order_relaxed);
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        T_Listener* l = m_listeners[i].load(std::memory_order_relaxed);
+        if (l != listener)
+          m_listeners[kept++].store(l, std::memory_order_relaxed);
+      }
+      m_count.store(kept, std::memory_order_relaxed);
+    }
+
+    //! Memory occupied by this container.
+    MemoryUsage memoryUsage() const
+    {
+      MemoryUsage usage;
+      usage.bytesUsed = usage.bytesReserved = sizeof(*this);
+      usage.liveEntries = read().count;
+      return usage;
+    }
+
+    //! Sort listeners by their address, see RawContainer::compact().
+    void compact()
+    {
+      Writer writer(*this);
+      Snapshot snapshot = read(writer);
+      std::sort(snapshot.listeners, snapshot.listeners + snapshot.count, std::less<T_Listener*>());
+      for (std::size_t i = 0; i < snapshot.count; ++i)
+        m_listeners[i].store(snapshot.listeners[i], std::memory_order_relaxed);
+    }
+
+  protected:
+
+    //! Call a notification function as specified by the first parameter.
+    /*!
+      All listeners registered in this container are notified.
+      The parameter pack is forwarded to that function.
+    */
+    template <typename... Fn_Args>
+    void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+    {
+      const Snapshot snapshot = read();
+      if (auto* monitor = detail::CallMonitor::sample())
+      {
+        for (std::size_t i = 0; i < snapshot.count; ++i)
+          detail::CallMonitor::timedCall(monitor, snapshot.listeners[i], fn, std::forward<Fn_Args>(args)...);
+        return;
+      }
+
+      for (std::size_t i = 0; i < snapshot.count; ++i)
+        (snapshot.listeners[i]->*fn)(std::forward<Fn_Args>(args)...);
+    }
+
+    //! Call \a function for every listener, see Source::notifyAsync().
+    template <class F>
+    void forEachListener(F&& function) const
+    {
+      const Snapshot snapshot = read();
+      for (std::size_t i = 0; i < snapshot.count; ++i)
+        function(snapshot.listeners[i]);
+    }
+
+  private:
+    struct Snapshot
+    {
+      std::size_t count = 0;
+      T_Listener* listeners[Capacity];
+    };
+
+    //! Holds the sequence number odd for its lifetime, i.e. excludes other writers and makes readers retry.
+    class Writer
+    {
+    public:
+      explicit Writer(Container& container)
+        : m_container(container)
+      {
+        auto& sequence = container.m_sequence;
+        unsigned value = sequence.load(std::memory_order_relaxed);
+        while ((value & 1) || !sequence.compare_exchange_weak(value, value + 1, std::memory_order_acquire))
+        {
+          std::this_thread::yield();
+          value = sequence.load(std::memory_order_relaxed);
+        }
+        // Stores to the array must not become visible before the odd sequence number.
+        std::atomic_thread_fence(std::memory_order_release);
+      }
+
+      Writer(const Writer&) = delete;
+      Writer& operator=(const Writer&) = delete;
+
+      ~Writer()
+      {
+        m_container.m_sequence.fetch_add(1, std::memory_order_release);
+      }
+
+    private:
+      Container& m_container;
+    };
+
+    //! Copy the listeners, retrying while a writer changes them.
+    Snapshot read() const
+    {
+      Snapshot snapshot;
+      for (;;)
+      {
+        unsigned before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+          std::this_thread::yield();
+          continue;
+        }
+        copy(snapshot);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before)
+          return snapshot;
+      }
+    }
+
+    //! Copy the listeners, the caller is the writer.
+    Snapshot read(const Writer&) const
+    {
+      Snapshot snapshot;
+      copy(snapshot);
+      return snapshot;
+    }
+
+    void copy(Snapshot& snapshot) const
+    {
+      // A torn copy is possible and is discarded by the caller, so the count must be clamped.
+      snapshot.count = std::min(m_count.load(std::memory_order_relaxed), Capacity);
+      for (std::size_t i = 0; i < snapshot.count; ++i)
+        snapshot.listeners[i] = m_listeners[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic<unsigned> m_sequence{0};
+    std::atomic<std::size_t> m_count{0};
+    std::atomic<T_Listener*> m_listeners[Capacity] = {};
+  };
+};
+
+//! Default capacity of Seqlocked containers.
+constexpr std::size_t DefaultSeqlockCapacity = 4;
+
+//! Shortcut for a source of at most \a T_Capacity listeners of each type guarded by sequence locks
+template <std::size_t T_Capacity, class... T_Listeners>
+using SeqlockSource = Source<Seqlocked<T_Capacity>::template Container, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_SEQLOCK_H
@@ -78,3 +78,25 @@ void test() {
 }
 
 //! [MultipleListenersExample]
+
+//! [QueuedExample]
+class QueuedMouseSource : public Observer::QueuedSource<MouseListener> {
+public:
+  using QueuedSource::QueuedSource;
+
+  void f() {
+    // ...
+    notify(&MouseListener::onLeftMouseButtonUp, 10, 20);
+    notify(Observer::Priority::High, &MouseListener::onRightMouseButtonUp, 10, 20);
+  }
+};
+
+void frame(Observer::Dispatcher& dispatcher) {
+  auto deadline = Observer::Dispatcher::Clock::now() + std::chrono::milliseconds(2);
+  auto report = dispatcher.drain(deadline);
+  if (report.backlog() > 0) {
+    // the rest is carried over to the next frame
+  }
+}
+
+//! [QueuedExample]
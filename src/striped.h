@@ -0,0 +1,295 @@
+#ifndef OBSERVER_STRIPED_H
+#define OBSERVER_STRIPED_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "observer.h"
+
+namespace Observer
+{
+
+//! Containers of listeners partitioned into \a T_Stripes stripes, each with its own lock.
+template <std::size_t T_Stripes>
+struct Striped
+{
+  static_assert(T_Stripes > 0, "Stripe count must be positive");
+
+  //! A container of listeners, which may be changed and notified from several threads at once.
+  /*!
+    A listener belongs to the stripe given by its address, so threads
+    attaching and detaching different listeners rarely wait for each other
+    and a change costs only the lock of one stripe, unlike RcuContainer,
+    which copies all listeners on every change.
+
+    A notification walks the stripes and copies a chunk of listeners of
+    a stripe at a time to the stack, while it holds the lock of the stripe.
+    Listeners are called without any lock held, so they may attach and detach
+    listeners of the same source. Detached listeners leave holes, which are
+    reused by attach() and removed by compact(), so that the positions of
+    listeners do not move under notifications running at the same time.
+    A listener detached by another thread may still receive a notification,
+    which copied it before detach() returned.
+
+    Holes of a stripe are not reused while a notification walks it and a walk
+    stops at the size of the stripe at its start, so a listener re-attached
+    during a notification is not called twice by it. Attaching under constant
+    notifications appends, compact() removes the holes left behind.
+  */
+  template <class T_Listener>
+  class Container
+  {
+  public:
+    //! Number of stripes.
+    static constexpr std::size_t StripeCount = T_Stripes;
+
+    //! Number of listeners copied by a notification at a time.
+    static constexpr std::size_t ChunkSize = 16;
+
+    Container() = default;
+
+    Container(const Container& other)
+    {
+      for (std::size_t i = 0; i < StripeCount; ++i)
+      {
+        std::lock_guard<std::mutex> lock(other.m_stripes[i].mutex);
+        m_stripes[i].listeners = other.m_stripes[i].listeners;
+        m_stripes[i].holes = other.m_stripes[i].holes;
+      }
+    }
+
+    Container& operator=(const Container& other)
+    {
+      if (this != &other)
+      {
+        for (std::size_t i = 0; i < StripeCount; ++i)
+        {
+          std::lock(m_stripes[i].mutex, other.m_stripes[i].mutex);
+          std::lock_guard<std::mutex> lock(m_stripes[i].mutex, std::adopt_lock);
+          std::lock_guard<std::mutex> otherLock(other.m_stripes[i].mutex, std::adopt_lock);
+          m_stripes[i].listeners = other.m_stripes[i].listeners;
+          m_stripes[i].holes = other.m_stripes[i].holes;
+        }
+      }
+      return *this;
+    }
+
+    virtual ~Container() {}
+
+    //! Attach listener \a listener to this container.
+    /*!
+      When attached, notifications are sent to the listener.
+    */
+    void attach(T_Listener* listener)
+    {
+      assert(listener);
+      Stripe& stripe = stripeOf(listener);
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      if (stripe.holes.empty() || stripe.walkers)
+      {
+        stripe.listeners.push_back(listener);
+        return;
+      }
+      stripe.listeners[stripe.holes.back()] = listener;
+      stripe.holes.pop_back();
+    }
+
+    //! Detach listener \a listener from this container.
+    /*!
+      When detached, notifications aren't sent to the listener anymore.
+    */
+    void detach(T_Listener* listener)
+    {
+      Stripe& stripe = stripeOf(listener);
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      for (std::size_t i = 0; i < stripe.listeners.size(); ++i)
+      {
+        if (stripe.listeners[i] == listener)
+        {
+          stripe.listeners[i] = nullptr;
+          stripe.holes.push_back(static_cast<std::uint32_t>(i));
+        }
+      }
+    }
+
+    //! Memory occupied by this container.
+    /*!
+      Holes left by detached listeners are reported as dead entries.
+    */
+    MemoryUsage memoryUsage() const
+    {
+      MemoryUsage usage;
+      usage.bytesUsed = usage.bytesReserved = sizeof(*this);
+      for (const auto& stripe : m_stripes)
+      {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto listeners = detail::vectorUsage(stripe.listeners, 0);
+        auto holes = detail::vectorUsage(stripe.holes, 0);
+        usage.bytesUsed += listeners.bytesUsed + holes.bytesUsed;
+        usage.bytesReserved += listeners.bytesReserved + holes.bytesReserved;
+        usage.liveEntries += stripe.listeners.size() - stripe.holes.size();
+        usage.deadEntries += stripe.holes.size();
+      }
+      return usage;
+    }
+
+    //! Release unused capacity.
+    void shrink()
+    {
+      for (auto& stripe : m_stripes)
+      {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.listeners.shrink_to_fit();
+        stripe.holes.shrink_to_fit();
+      }
+    }
+
+    //! Remove holes and sort listeners of every stripe by their address, see RawContainer::compact().
+    /*!
+      Notifications running at the same time may miss listeners, which are moved,
+      or call them twice.
+    */
+    void compact()
+    {
+      for (auto& stripe : m_stripes)
+      {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.listeners.erase(std::remove(stripe.listeners.begin(), stripe.listeners.end(), nullptr),
+          stripe.listeners.end());
+        stripe.holes.clear();
+        std::sort(stripe.listeners.begin(), stripe.listeners.end(), std::less<T_Listener*>());
+      }
+    }
+
+  protected:
+
+    //! Call a notification function as specified by the first parameter.
+    /*!
+      All listeners registered in this container are notified.
+      The parameter pack is forwarded to that function.
+    */
+    template <typename... Fn_Args>
+    void notify(void (T_Listener::*fn)(Fn_Args...), Fn_Args&&... args)
+    {
+      auto* monitor = detail::CallMonitor::sample();
+      T_Listener* chunk[ChunkSize];
+      for (auto& stripe : m_stripes)
+      {
+        Walk walk(stripe);
+        for (std::size_t offset = 0; offset < walk.end; offset += ChunkSize)
+        {
+          std::size_t count = 0;
+          {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            const std::size_t size = std::min(walk.end, stripe.listeners.size());
+            for (std::size_t i = offset; i < size && i < offset + ChunkSize; ++i)
+            {
+              if (stripe.listeners[i])
+                chunk[count++] = stripe.listeners[i];
+            }
+            // The last chunk is copied, attach() may reuse holes again.
+            if (offset + ChunkSize >= walk.end)
+              walk.finish();
+          }
+
+          for (std::size_t i = 0; i < count; ++i)
+          {
+            if (monitor)
+              detail::CallMonitor::timedCall(monitor, chunk[i], fn, std::forward<Fn_Args>(args)...);
+            else
+              (chunk[i]->*fn)(std::forward<Fn_Args>(args)...);
+          }
+        }
+      }
+    }
+
+    //! Call \a function for every listener, see Source::notifyAsync().
+    template <class F>
+    void forEachListener(F&& function) const
+    {
+      for (auto& stripe : m_stripes)
+      {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (auto* l : stripe.listeners)
+        {
+          if (l)
+            function(l);
+        }
+      }
+    }
+
+  private:
+    struct alignas(64) Stripe
+    {
+      mutable std::mutex mutex;
+      // Detached listeners are replaced by null, their positions are kept in holes.
+      std::vector<T_Listener*> listeners;
+      std::vector<std::uint32_t> holes;
+      // Notifications walking this stripe, while holes must not be reused.
+      std::size_t walkers = 0;
+    };
+
+    //! Registration of a notification walking a stripe up to its size at the start.
+    struct Walk
+    {
+      explicit Walk(Stripe& stripe)
+        : stripe(stripe)
+      {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        end = stripe.listeners.size();
+        if (end)
+          ++stripe.walkers;
+      }
+
+      Walk(const Walk&) = delete;
+      Walk& operator=(const Walk&) = delete;
+
+      ~Walk()
+      {
+        // A listener has thrown before the last chunk was copied.
+        if (end && !finished)
+        {
+          std::lock_guard<std::mutex> lock(stripe.mutex);
+          --stripe.walkers;
+        }
+      }
+
+      //! Unregister, while the lock of the stripe is held.
+      void finish()
+      {
+        --stripe.walkers;
+        finished = true;
+      }
+
+      Stripe& stripe;
+      std::size_t end = 0;
+      bool finished = false;
+    };
+
+    Stripe& stripeOf(const T_Listener* listener)
+    {
+      // Fibonacci hashing spreads listeners allocated next to each other.
+      auto address = reinterpret_cast<std::uintptr_t>(listener);
+      auto hash = static_cast<std::uint64_t>(address >> 4) * 0x9E3779B97F4A7C15ull;
+      return m_stripes[(hash >> 32) % StripeCount];
+    }
+
+    Stripe m_stripes[StripeCount];
+  };
+};
+
+//! Default number of stripes of Striped containers.
+constexpr std::size_t DefaultStripeCount = 16;
+
+//! Shortcut for a source, whose containers are partitioned into \a T_Stripes stripes
+template <std::size_t T_Stripes, class... T_Listeners>
+using StripedSource = Source<Striped<T_Stripes>::template Container, T_Listeners...>;
+
+} // namespace Observer
+
+#endif // OBSERVER_STRIPED_H
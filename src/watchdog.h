@@ -0,0 +1,170 @@
+#ifndef OBSERVER_WATCHDOG_H
+#define OBSERVER_WATCHDOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "observer.h"
+
+namespace Observer
+{
+
+//! Detects listeners, which exceed a time budget when handling notifications.
+/*!
+  When started, the watchdog becomes the monitor of all containers. Once in
+  sampleInterval notifications per thread, the container times each listener
+  call and reports it to the watchdog. Calls exceeding the budget are recorded
+  per (listener, method) pair and passed to the callback, if there is any.
+  Notifications, which are not sampled, cost one decrement of a thread local
+  counter, they don't read the clock.
+
+  All containers of this library are sampled. Queued notifications and those
+  of listeners promoted by AdaptiveContainer are sampled on the thread, which
+  drains the dispatcher. Broadcasts run by Executor are not sampled.
+
+  Only one watchdog may be active at a time. The watchdog must not be destroyed
+  while a notification, which is being sampled, is in progress.
+*/
+class Watchdog : public detail::CallMonitor
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  //! Record of calls of a listener method, which exceeded the budget.
+  struct Overrun
+  {
+    //! The listener, which was slow.
+    const void* listener = nullptr;
+    //! The notification method.
+    MethodId method;
+    //! Number of sampled calls over budget.
+    std::size_t count = 0;
+    //! The longest sampled call.
+    std::chrono::nanoseconds worst{0};
+    //! Sum of the time over budget of all sampled calls.
+    std::chrono::nanoseconds excess{0};
+  };
+
+  //! Called on the notifying thread right after a call has exceeded the budget.
+  using Callback = std::function<void(const Overrun& overrun, std::chrono::nanoseconds elapsed)>;
+
+  explicit Watchdog(std::chrono::nanoseconds budget, std::uint32_t sampleInterval = 64)
+    : m_budget(budget)
+    , m_sampleInterval(sampleInterval)
+  {
+    assert(sampleInterval > 0);
+  }
+
+  ~Watchdog()
+  {
+    stop();
+  }
+
+  //! Start checking of notifications of all containers.
+  void start()
+  {
+    activate(this);
+  }
+
+  //! Stop checking of notifications.
+  void stop()
+  {
+    deactivate(this);
+  }
+
+  //! Set the function, which is called when a call exceeds the budget.
+  /*!
+    Must not be called while the watchdog is running.
+  */
+  void setCallback(Callback callback)
+  {
+    m_callback = std::move(callback);
+  }
+
+  //! Snapshot of all recorded overruns.
+  std::vector<Overrun> overruns() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Overrun> result;
+    result.reserve(m_overruns.size());
+    for (const auto& entry : m_overruns)
+      result.push_back(entry.second);
+    return result;
+  }
+
+  //! Number of calls, which were timed.
+  std::size_t sampledCalls() const
+  {
+    return m_sampledCalls.load(std::memory_order_relaxed);
+  }
+
+  //! Forget all recorded overruns.
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overruns.clear();
+    m_sampledCalls.store(0, std::memory_order_relaxed);
+  }
+
+  std::uint32_t sampleInterval() const override
+  {
+    return m_sampleInterval;
+  }
+
+  void report(const void* listener, const MethodId& method, std::chrono::nanoseconds elapsed) override
+  {
+    m_sampledCalls.fetch_add(1, std::memory_order_relaxed);
+    if (elapsed <= m_budget)
+      return;
+
+    Overrun snapshot;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto& overrun = m_overruns[Key{ listener, method }];
+      overrun.listener = listener;
+      overrun.method = method;
+      ++overrun.count;
+      overrun.worst = std::max(overrun.worst, elapsed);
+      overrun.excess += elapsed - m_budget;
+      snapshot = overrun;
+    }
+    if (m_callback)
+      m_callback(snapshot, elapsed);
+  }
+
+private:
+  struct Key
+  {
+    const void* listener;
+    MethodId method;
+
+    bool operator==(const Key& other) const
+    {
+      return listener == other.listener && method == other.method;
+    }
+  };
+
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const
+    {
+      return std::hash<const void*>()(key.listener) ^ (key.method.hash() << 1);
+    }
+  };
+
+  const std::chrono::nanoseconds m_budget;
+  const std::uint32_t m_sampleInterval;
+  Callback m_callback;
+  std::atomic<std::size_t> m_sampledCalls{0};
+  mutable std::mutex m_mutex;
+  std::unordered_map<Key, Overrun, KeyHash> m_overruns;
+};
+
+} // namespace Observer
+
+#endif // OBSERVER_WATCHDOG_H